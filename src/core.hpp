@@ -5,6 +5,9 @@
 #include "../src/core/common.hpp"
 #include "../src/core/metric.hpp"
 
+#include "../src/core/parallel/thread_pool.hpp"
+#include "../src/core/parallel/parallel_for.hpp"
+
 #include "../src/core/math/ops.hpp"
 #include "../src/core/math/proba.hpp"
 #include "../src/core/math/random.hpp"
@@ -12,7 +15,12 @@
 #include "../src/core/math/extmath.hpp"
 #include "../src/core/math/linalg.hpp"
 
+#include "../src/core/metric/pairwise.hpp"
+
+#include "../src/core/data/mapped_file.hpp"
 #include "../src/core/data/load.hpp"
+#include "../src/core/data/binary.hpp"
+#include "../src/core/data/data_source.hpp"
 #include "../src/core/data/split.hpp"
 
 #include "../src/core/loss/log_loss.hpp"
@@ -31,7 +39,12 @@
 #include "../src/core/preprocessing/transaction_encoder.hpp"
 
 #include "../src/core/tree/hash_tree.hpp"
+#include "../src/core/tree/query.hpp"
 #include "../src/core/tree/kd_tree.hpp"
+#include "../src/core/tree/dynamic_kd_tree.hpp"
+#include "../src/core/tree/kd_forest.hpp"
+#include "../src/core/tree/ball_tree.hpp"
+#include "../src/core/tree/hnsw.hpp"
 
 
 
@@ -0,0 +1,301 @@
+#ifndef CORE_DATA_BINARY_HPP
+#define CORE_DATA_BINARY_HPP
+#include "../../prereqs.hpp"
+#include "./mapped_file.hpp"
+
+namespace openml {
+namespace data {
+
+/**
+ * On-disk layout of a binary dataset file
+ *
+ *      [BinaryHeader, 64 bytes][padding][X payload][padding][y payload]
+ *
+ * payloads start at a multiple of 64 bytes from the beginning of the file,
+ * since a mapping is page aligned, the mapped payloads are 64-byte aligned
+ * and can be viewed directly as Eigen matrices.
+*/
+struct BinaryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint8_t dtype;
+    std::uint8_t row_major;
+    std::uint8_t has_label;
+    std::uint8_t reserved[5];
+    std::uint64_t num_rows;
+    std::uint64_t num_cols;
+    std::uint64_t x_offset;
+    std::uint64_t y_offset;
+    std::uint64_t checksum;
+};
+static_assert(sizeof(BinaryHeader) == 64, "BinaryHeader must be 64 bytes.");
+
+constexpr char BINARY_MAGIC[8] = {'O', 'P', 'E', 'N', 'M', 'L', 'B', 'N'};
+constexpr std::uint32_t BINARY_VERSION = 1;
+constexpr std::uint32_t BINARY_BYTE_ORDER = 0x01020304;
+constexpr std::size_t BINARY_ALIGNMENT = 64;
+
+/**
+ * dtype code stored in the header for the supported value types
+*/
+template<typename DataType>
+constexpr std::uint8_t binary_dtype() {
+    static_assert(std::is_arithmetic<DataType>::value, "dtype must be arithmetic.");
+    if (std::is_same<DataType, float>::value) {
+        return 1;
+    }
+    else if (std::is_same<DataType, double>::value) {
+        return 2;
+    }
+    else if (std::is_same<DataType, std::int32_t>::value) {
+        return 3;
+    }
+    else if (std::is_same<DataType, std::int64_t>::value) {
+        return 4;
+    }
+    return 0;
+};
+
+inline std::size_t align_offset(std::size_t offset) {
+    return (offset + BINARY_ALIGNMENT - 1) / BINARY_ALIGNMENT * BINARY_ALIGNMENT;
+};
+
+/**
+ * FNV-1a style hash on 64-bit words, the tail bytes are hashed one by one
+*/
+inline std::uint64_t checksum(const char* data,
+    std::size_t size,
+    std::uint64_t hash = 14695981039346656037ULL) {
+
+    const std::uint64_t prime = 1099511628211ULL;
+    std::size_t num_words = size / sizeof(std::uint64_t);
+    for (std::size_t i = 0; i < num_words; ++i) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i * sizeof(std::uint64_t), sizeof(std::uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+    for (std::size_t i = num_words * sizeof(std::uint64_t); i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+    return hash;
+};
+
+/**
+ * save dataset into a binary file
+ *
+ * @param fp String the given filepath
+ * @param X 2d-array of shape (num_samples, num_features) the input matrix,
+ *      stored with its own storage order
+ * @param y 1d-array of shape (num_samples, 1) the label vector,
+ *      an empty vector means no label is stored
+*/
+template<typename MatType,
+    typename VecType,
+    typename DataType = typename MatType::Scalar>
+void savebin(const std::string& fp,
+    const MatType& X,
+    const VecType& y) {
+
+    static_assert(binary_dtype<DataType>() != 0, "Unsupported dtype.");
+    static_assert(std::is_same<DataType, typename VecType::Scalar>::value,
+        "X and y must have the same dtype.");
+
+    std::size_t num_rows = X.rows(), num_cols = X.cols();
+    bool has_label = (y.size() != 0);
+    if (has_label && static_cast<std::size_t>(y.size()) != num_rows) {
+        std::ostringstream err_msg;
+        err_msg << "Number of labels " << y.size()
+                << " != number of samples " << num_rows << std::endl;
+        throw std::invalid_argument(err_msg.str());
+    }
+    // payloads must be contiguous, plain objects are bound directly,
+    // expressions and maps are evaluated into a temporary
+    const typename MatType::PlainObject& x_payload = X;
+    const typename VecType::PlainObject& y_payload = y;
+    std::size_t x_bytes = num_rows * num_cols * sizeof(DataType);
+    std::size_t y_bytes = has_label ? num_rows * sizeof(DataType) : 0;
+
+    BinaryHeader header;
+    std::memset(&header, 0, sizeof(BinaryHeader));
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.byte_order = BINARY_BYTE_ORDER;
+    header.dtype = binary_dtype<DataType>();
+    header.row_major = MatType::IsRowMajor ? 1 : 0;
+    header.has_label = has_label ? 1 : 0;
+    header.num_rows = num_rows;
+    header.num_cols = num_cols;
+    header.x_offset = align_offset(sizeof(BinaryHeader));
+    header.y_offset = has_label ? align_offset(header.x_offset + x_bytes) : 0;
+    header.checksum = checksum(
+        reinterpret_cast<const char*>(x_payload.data()), x_bytes
+    );
+    header.checksum = checksum(
+        reinterpret_cast<const char*>(y_payload.data()), y_bytes, header.checksum
+    );
+
+    std::ofstream fout(fp, std::ios::binary | std::ios::trunc);
+    if (!fout) {
+        throw std::runtime_error("Output file could not be opened.");
+    }
+    const std::vector<char> padding(BINARY_ALIGNMENT, 0);
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+    fout.write(padding.data(), header.x_offset - sizeof(BinaryHeader));
+    fout.write(reinterpret_cast<const char*>(x_payload.data()), x_bytes);
+    if (has_label) {
+        fout.write(padding.data(), header.y_offset - header.x_offset - x_bytes);
+        fout.write(reinterpret_cast<const char*>(y_payload.data()), y_bytes);
+    }
+    if (!fout) {
+        throw std::runtime_error("Could not write output file.");
+    }
+};
+
+/**
+ * save dataset without label into a binary file
+*/
+template<typename MatType,
+    typename DataType = typename MatType::Scalar>
+void savebin(const std::string& fp, const MatType& X) {
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    savebin<MatType, VecType>(fp, X, VecType());
+};
+
+/**
+ * Memory mapped binary dataset. Opening a file only reads the header,
+ * X and y are zero-copy views into the mapping, they are valid as long
+ * as the BinaryDataset object is alive.
+ *
+ * @param fp String the given filepath
+ * @param verify bool, default false, whether to check the payload checksum,
+ *      it reads the whole file.
+*/
+template<typename DataType, int Order = Eigen::ColMajor>
+class BinaryDataset {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic, Order>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using MatMapType = Eigen::Map<const MatType, Eigen::Aligned64>;
+    using VecMapType = Eigen::Map<const VecType, Eigen::Aligned64>;
+
+    MappedFile file_;
+    BinaryHeader header_;
+
+    void check_header(bool verify) const {
+        std::ostringstream err_msg;
+        if (file_.size() < sizeof(BinaryHeader) ||
+            std::memcmp(header_.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+            err_msg << "Input file is not a binary dataset." << std::endl;
+            throw std::runtime_error(err_msg.str());
+        }
+        if (header_.version != BINARY_VERSION ||
+            header_.byte_order != BINARY_BYTE_ORDER) {
+            err_msg << "Unsupported binary version " << header_.version
+                    << " or byte order." << std::endl;
+            throw std::runtime_error(err_msg.str());
+        }
+        if (header_.dtype != binary_dtype<DataType>()) {
+            err_msg << "dtype of file " << static_cast<int>(header_.dtype)
+                    << " does not match the requested dtype "
+                    << static_cast<int>(binary_dtype<DataType>()) << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (static_cast<bool>(header_.row_major) != MatType::IsRowMajor) {
+            err_msg << "Storage order of file does not match the requested order." << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+
+        // sizes are compared by division, the products of an
+        // untrusted header could wrap around
+        std::size_t size = file_.size();
+        bool valid = header_.x_offset % BINARY_ALIGNMENT == 0 &&
+            header_.y_offset % BINARY_ALIGNMENT == 0 &&
+            header_.x_offset <= size && 
+            header_.y_offset <= size;
+        if (valid && header_.num_cols != 0) {
+            std::size_t x_capacity = (size - header_.x_offset) / sizeof(DataType);
+            valid = header_.num_rows <= x_capacity / header_.num_cols;
+        }
+        if (valid && header_.has_label) {
+            std::size_t y_capacity = (size - header_.y_offset) / sizeof(DataType);
+            valid = header_.num_rows <= y_capacity;
+        }
+        if (!valid) {
+            err_msg << "Binary dataset is truncated or corrupted." << std::endl;
+            throw std::runtime_error(err_msg.str());
+        }
+        std::size_t x_bytes = x_num_bytes(), y_bytes = y_num_bytes();
+        if (verify) {
+            std::uint64_t hash = checksum(file_.data() + header_.x_offset, x_bytes);
+            hash = checksum(file_.data() + header_.y_offset, y_bytes, hash);
+            if (hash != header_.checksum) {
+                err_msg << "Checksum mismatch, binary dataset is corrupted." << std::endl;
+                throw std::runtime_error(err_msg.str());
+            }
+        }
+    }
+
+    // only called once the header is checked, the products can not overflow
+    std::size_t x_num_bytes() const {
+        return header_.num_rows * header_.num_cols * sizeof(DataType);
+    }
+
+    std::size_t y_num_bytes() const {
+        return header_.has_label ? header_.num_rows * sizeof(DataType) : 0;
+    }
+
+public:
+    explicit BinaryDataset(const std::string& fp, bool verify = false): file_(fp) {
+        std::memset(&header_, 0, sizeof(BinaryHeader));
+        if (file_.size() >= sizeof(BinaryHeader)) {
+            std::memcpy(&header_, file_.data(), sizeof(BinaryHeader));
+        }
+        check_header(verify);
+    };
+
+    // the mapping is owned by file_, a dataset can be moved but not copied
+    BinaryDataset(BinaryDataset&&) noexcept = default;
+    BinaryDataset& operator=(BinaryDataset&&) noexcept = default;
+
+    ~BinaryDataset() {};
+
+    /**
+     * zero-copy view of the feature matrix of shape (num_samples, num_features)
+    */
+    const MatMapType X() const {
+        return MatMapType(
+            reinterpret_cast<const DataType*>(file_.data() + header_.x_offset),
+            header_.num_rows, header_.num_cols
+        );
+    }
+
+    /**
+     * zero-copy view of the label vector of shape (num_samples, 1)
+    */
+    const VecMapType y() const {
+        if (!header_.has_label) {
+            throw std::runtime_error("Binary dataset does not contain label.");
+        }
+        return VecMapType(
+            reinterpret_cast<const DataType*>(file_.data() + header_.y_offset),
+            header_.num_rows
+        );
+    }
+
+    std::size_t rows() const {
+        return header_.num_rows;
+    }
+
+    std::size_t cols() const {
+        return header_.num_cols;
+    }
+
+    bool has_label() const {
+        return header_.has_label != 0;
+    }
+};
+
+}
+}
+#endif /*CORE_DATA_BINARY_HPP*/
@@ -0,0 +1,520 @@
+#ifndef CORE_DATA_DATA_SOURCE_HPP
+#define CORE_DATA_DATA_SOURCE_HPP
+#include "../../prereqs.hpp"
+#include "./load.hpp"
+#include "./binary.hpp"
+#include "../math/random.hpp"
+
+namespace openml {
+namespace data {
+
+/**
+ * Abstract source of mini-batches. Optimizers pull batches from a source
+ * until it is exhausted, then reset it at the beginning of the next epoch,
+ * so only the current batch has to be resident in memory.
+*/
+template<typename DataType>
+class DataSource {
+protected:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+
+    /**
+     * resize batch buffers only if the number of rows changes,
+     * buffers are reused across batches without allocation
+    */
+    static void resize_batch(MatType& X, VecType& y,
+        std::size_t num_rows,
+        std::size_t num_cols) {
+        if (static_cast<std::size_t>(X.rows()) != num_rows ||
+            static_cast<std::size_t>(X.cols()) != num_cols) {
+            X.resize(num_rows, num_cols);
+        }
+        if (static_cast<std::size_t>(y.rows()) != num_rows) {
+            y.resize(num_rows);
+        }
+    }
+
+public:
+    virtual ~DataSource() {};
+
+    /**
+     * rewind the source to the beginning of an epoch
+    */
+    virtual void reset() = 0;
+
+    /**
+     * read the next mini-batch
+     *
+     * @param X output matrix of shape (num_rows, num_features)
+     * @param y output label vector of shape (num_rows, 1)
+     * @param batch_size maximum number of samples to read
+     * @return number of samples read, 0 means the end of epoch
+    */
+    virtual std::size_t next_batch(MatType& X,
+        VecType& y,
+        std::size_t batch_size) = 0;
+
+    virtual std::size_t num_features() const = 0;
+};
+
+/**
+ * Mini-batch source over matrices already in memory, input data are
+ * referenced and not copied. Shuffling only permutes an index vector,
+ * batches are gathered from the input into the reused batch buffers.
+ *
+ * @param shuffle bool, whether to shuffle samples
+ * @param shuffle_mode string, how samples are shuffled
+ *      "epoch": permute all samples at each epoch
+ *      "once": permute all samples once, at the first epoch
+ *      "block": permute the order of contiguous blocks of block_size 
+ *          samples at each epoch, a batch aligned on blocks reads 
+ *          contiguous rows
+ * @param block_size number of samples of a block for "block" mode
+ * @param random_state long, seed of the shuffle, default -1 means
+ *      the generator is taken from the global seed
+ * @param drop_last bool, whether to drop the last batch of an epoch 
+ *      if it has fewer than batch_size samples
+*/
+template<typename DataType>
+class InMemoryDataSource: public DataSource<DataType> {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+
+    const MatType& X_;
+    const VecType& y_;
+    bool shuffle_;
+    bool shuffled_;
+    std::string shuffle_mode_;
+    std::size_t block_size_;
+    bool drop_last_;
+    std::size_t pos_;
+    IdxVecType indices_;
+    std::vector<std::size_t> blocks_;
+    random::Philox4x32 generator_;
+
+    void shuffle_blocks() {
+        std::size_t num_samples = X_.rows();
+        random::shuffle(blocks_.begin(), blocks_.end(), generator_);
+        std::size_t k = 0;
+        for (std::size_t block : blocks_) {
+            std::size_t begin = block * block_size_;
+            std::size_t end = std::min(begin + block_size_, num_samples);
+            for (std::size_t i = begin; i < end; ++i) {
+                indices_(k++) = i;
+            }
+        }
+    }
+
+public:
+    InMemoryDataSource(const MatType& X,
+        const VecType& y,
+        bool shuffle = false,
+        std::string shuffle_mode = "epoch",
+        std::size_t block_size = 64,
+        long random_state = -1,
+        bool drop_last = false): X_(X),
+            y_(y),
+            shuffle_(shuffle),
+            shuffled_(false),
+            shuffle_mode_(shuffle_mode),
+            block_size_(block_size),
+            drop_last_(drop_last),
+            pos_(0),
+            generator_(random::make_generator(random_state)) {
+        if (X.rows() != y.rows()) {
+            throw std::invalid_argument("X and y must have the same number of rows.");
+        }
+        if (shuffle_mode != "epoch" && shuffle_mode != "once" && shuffle_mode != "block") {
+            throw std::invalid_argument("shuffle_mode must be 'epoch', 'once' or 'block'.");
+        }
+        if (block_size == 0) {
+            throw std::invalid_argument("block_size must be positive.");
+        }
+        indices_ = IdxVecType::LinSpaced(X.rows(), 0, X.rows() - 1);
+        if (shuffle_mode == "block") {
+            std::size_t num_blocks = (X.rows() + block_size - 1) / block_size;
+            blocks_.resize(num_blocks);
+            std::iota(blocks_.begin(), blocks_.end(), 0);
+        }
+    };
+
+    ~InMemoryDataSource() {};
+
+    void reset() {
+        pos_ = 0;
+        if (!shuffle_) {
+            return ;
+        }
+        if (shuffle_mode_ == "epoch") {
+            random::shuffle(indices_.data(), indices_.data() + indices_.size(), generator_);
+        }
+        else if (shuffle_mode_ == "once" && !shuffled_) {
+            random::shuffle(indices_.data(), indices_.data() + indices_.size(), generator_);
+        }
+        else if (shuffle_mode_ == "block") {
+            shuffle_blocks();
+        }
+        shuffled_ = true;
+    }
+
+    std::size_t next_batch(MatType& X,
+        VecType& y,
+        std::size_t batch_size) {
+
+        std::size_t num_samples = X_.rows();
+        std::size_t num_rows = std::min(batch_size, num_samples - pos_);
+        if (num_rows == 0 || (drop_last_ && num_rows < batch_size)) {
+            return 0;
+        }
+        this->resize_batch(X, y, num_rows, X_.cols());
+        // gathering rows of a contiguous range is a block copy
+        Eigen::Index first = indices_(pos_);
+        bool contiguous = !shuffle_;
+        if (shuffle_ && shuffle_mode_ == "block") {
+            contiguous = true;
+            for (std::size_t i = 1; i < num_rows && contiguous; ++i) {
+                contiguous = (indices_(pos_ + i) == first + static_cast<Eigen::Index>(i));
+            }
+        }
+        if (contiguous) {
+            X = X_.middleRows(first, num_rows);
+            y = y_.segment(first, num_rows);
+        }
+        else {
+            auto batch_indices = indices_.segment(pos_, num_rows);
+            X = X_(batch_indices, Eigen::all);
+            y = y_(batch_indices);
+        }
+        pos_ += num_rows;
+        return num_rows;
+    }
+
+    std::size_t num_features() const {
+        return X_.cols();
+    }
+};
+
+/**
+ * Mini-batch source reading a binary dataset file sequentially,
+ * the file is memory mapped so resident pages are managed by the OS.
+*/
+template<typename DataType>
+class BinaryDataSource: public DataSource<DataType> {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+
+    BinaryDataset<DataType> dataset_;
+    std::size_t pos_;
+
+public:
+    explicit BinaryDataSource(const std::string& fp): dataset_(fp), pos_(0) {
+        if (!dataset_.has_label()) {
+            throw std::invalid_argument("Binary dataset does not contain label.");
+        }
+    };
+
+    ~BinaryDataSource() {};
+
+    void reset() {
+        pos_ = 0;
+    }
+
+    std::size_t next_batch(MatType& X,
+        VecType& y,
+        std::size_t batch_size) {
+
+        std::size_t num_rows = std::min(batch_size, dataset_.rows() - pos_);
+        if (num_rows == 0) {
+            return 0;
+        }
+        this->resize_batch(X, y, num_rows, dataset_.cols());
+        X = dataset_.X().middleRows(pos_, num_rows);
+        y = dataset_.y().segment(pos_, num_rows);
+        pos_ += num_rows;
+        return num_rows;
+    }
+
+    std::size_t num_features() const {
+        return dataset_.cols();
+    }
+};
+
+/**
+ * Mini-batch source reading a text file in chunks of buffer_size bytes,
+ * the file follows the loadtxt layout, the last column of each line is the label.
+*/
+template<typename DataType>
+class TextDataSource: public DataSource<DataType> {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+
+    std::ifstream fin_;
+    std::size_t buffer_size_;
+    std::size_t num_features_;
+    std::size_t pos_;
+    std::string buffer_;
+
+    /**
+     * read the next chunk of text, the unparsed tail of the previous
+     * chunk is kept at the front of the buffer
+    */
+    bool fill_buffer() {
+        if (!fin_) {
+            return false;
+        }
+        buffer_.erase(0, pos_);
+        pos_ = 0;
+        std::size_t tail_size = buffer_.size();
+        buffer_.resize(tail_size + buffer_size_);
+        fin_.read(&buffer_[tail_size], buffer_size_);
+        buffer_.resize(tail_size + static_cast<std::size_t>(fin_.gcount()));
+        // make sure the last line of file is terminated
+        if (!fin_ && !buffer_.empty() && buffer_.back() != '\n') {
+            buffer_.push_back('\n');
+        }
+        return buffer_.size() > tail_size;
+    }
+
+    /**
+     * get the next non-empty complete line of the buffer
+    */
+    bool next_line(const char*& first, const char*& last) {
+        while (true) {
+            const char* begin = buffer_.data() + pos_;
+            const char* end = buffer_.data() + buffer_.size();
+            const void* eol = std::memchr(begin, '\n', end - begin);
+            if (eol == nullptr) {
+                if (!fill_buffer()) {
+                    return false;
+                }
+                continue;
+            }
+            first = begin;
+            last = static_cast<const char*>(eol);
+            pos_ = last - buffer_.data() + 1;
+            while (first != last && is_separator(*first)) {
+                ++first;
+            }
+            if (first != last) {
+                return true;
+            }
+        }
+    }
+
+public:
+    TextDataSource(const std::string& fp,
+        std::size_t buffer_size = 1 << 22): fin_(fp, std::ios::binary),
+            buffer_size_(buffer_size),
+            num_features_(0),
+            pos_(0) {
+        if (!fin_) {
+            throw std::runtime_error("Input file could not be opened.");
+        }
+        const char *first, *last;
+        if (!next_line(first, last)) {
+            throw std::runtime_error("Input file is empty.");
+        }
+        std::size_t num_cols = count_tokens(first, last);
+        if (num_cols < 2) {
+            throw std::runtime_error("Input file needs at least one feature and a label.");
+        }
+        num_features_ = num_cols - 1;
+        reset();
+    };
+
+    ~TextDataSource() {};
+
+    void reset() {
+        fin_.clear();
+        fin_.seekg(0);
+        buffer_.clear();
+        pos_ = 0;
+    }
+
+    std::size_t next_batch(MatType& X,
+        VecType& y,
+        std::size_t batch_size) {
+
+        this->resize_batch(X, y, batch_size, num_features_);
+        std::size_t num_rows = 0;
+        const char *first, *last;
+        while (num_rows < batch_size && next_line(first, last)) {
+            DataType value;
+            std::size_t col = 0;
+            while (col <= num_features_ && parse_next(first, last, value)) {
+                if (col < num_features_) {
+                    X(num_rows, col) = value;
+                }
+                else {
+                    y(num_rows) = value;
+                }
+                ++col;
+            }
+            if (col != num_features_ + 1 || parse_next(first, last, value)) {
+                std::ostringstream err_msg;
+                err_msg << "Line does not have " << num_features_ + 1
+                        << " values." << std::endl;
+                throw std::invalid_argument(err_msg.str());
+            }
+            ++num_rows;
+        }
+        // the last batch of an epoch can be smaller
+        if (num_rows < batch_size) {
+            X.conservativeResize(num_rows, Eigen::NoChange);
+            y.conservativeResize(num_rows);
+        }
+        return num_rows;
+    }
+
+    std::size_t num_features() const {
+        return num_features_;
+    }
+};
+
+/**
+ * Approximate shuffling of a stream with a bounded buffer. The buffer is
+ * filled with the first buffer_size samples of the source, each output sample
+ * is drawn uniformly from the buffer and its slot is refilled with the next
+ * sample of the source. Memory is bounded by buffer_size samples.
+*/
+template<typename DataType>
+class ShuffleDataSource: public DataSource<DataType> {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+
+    DataSource<DataType>& source_;
+    std::size_t buffer_size_;
+    std::size_t chunk_size_;
+    std::size_t count_;
+    std::size_t chunk_pos_;
+    MatType buffer_X_;
+    VecType buffer_y_;
+    MatType chunk_X_;
+    VecType chunk_y_;
+    random::Philox4x32 generator_;
+
+    /**
+     * pull one sample from the underlying source into buffer slot i
+    */
+    bool pull(std::size_t i) {
+        if (chunk_pos_ >= static_cast<std::size_t>(chunk_X_.rows())) {
+            chunk_pos_ = 0;
+            if (source_.next_batch(chunk_X_, chunk_y_, chunk_size_) == 0) {
+                chunk_X_.resize(0, chunk_X_.cols());
+                return false;
+            }
+        }
+        buffer_X_.row(i) = chunk_X_.row(chunk_pos_);
+        buffer_y_(i) = chunk_y_(chunk_pos_);
+        ++chunk_pos_;
+        return true;
+    }
+
+public:
+    ShuffleDataSource(DataSource<DataType>& source,
+        std::size_t buffer_size = 10000,
+        std::size_t chunk_size = 256): source_(source),
+            buffer_size_(buffer_size),
+            chunk_size_(chunk_size),
+            count_(0),
+            chunk_pos_(0),
+            generator_(random::global_generator()) {
+        if (buffer_size_ == 0 || chunk_size_ == 0) {
+            throw std::invalid_argument("buffer_size and chunk_size must be positive.");
+        }
+        buffer_X_.resize(buffer_size_, source_.num_features());
+        buffer_y_.resize(buffer_size_);
+    };
+
+    ~ShuffleDataSource() {};
+
+    void reset() {
+        source_.reset();
+        chunk_X_.resize(0, source_.num_features());
+        chunk_pos_ = 0;
+        count_ = 0;
+        while (count_ < buffer_size_ && pull(count_)) {
+            ++count_;
+        }
+    }
+
+    std::size_t next_batch(MatType& X,
+        VecType& y,
+        std::size_t batch_size) {
+
+        std::size_t num_rows = std::min(batch_size, count_);
+        if (num_rows == 0) {
+            return 0;
+        }
+        this->resize_batch(X, y, num_rows, source_.num_features());
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            std::size_t j = random::uniform_index(generator_, count_);
+            X.row(i) = buffer_X_.row(j);
+            y(i) = buffer_y_(j);
+            // refill the slot, once the source is exhausted the
+            // buffer shrinks by moving its last sample into the slot
+            if (!pull(j)) {
+                --count_;
+                buffer_X_.row(j) = buffer_X_.row(count_);
+                buffer_y_(j) = buffer_y_(count_);
+            }
+        }
+        return num_rows;
+    }
+
+    std::size_t num_features() const {
+        return source_.num_features();
+    }
+};
+
+/**
+ * Append a column of ones to the batches of a source,
+ * used by linear models to fit the intercept term.
+*/
+template<typename DataType>
+class InterceptDataSource: public DataSource<DataType> {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+
+    DataSource<DataType>& source_;
+    MatType batch_X_;
+
+public:
+    explicit InterceptDataSource(DataSource<DataType>& source): source_(source) {};
+
+    ~InterceptDataSource() {};
+
+    void reset() {
+        source_.reset();
+    }
+
+    std::size_t next_batch(MatType& X,
+        VecType& y,
+        std::size_t batch_size) {
+
+        std::size_t num_rows = source_.next_batch(batch_X_, y, batch_size);
+        if (num_rows == 0) {
+            return 0;
+        }
+        std::size_t num_features = source_.num_features();
+        this->resize_batch(X, y, num_rows, num_features + 1);
+        X.leftCols(num_features) = batch_X_;
+        X.col(num_features).setOnes();
+        return num_rows;
+    }
+
+    std::size_t num_features() const {
+        return source_.num_features() + 1;
+    }
+};
+
+}
+}
+#endif /*CORE_DATA_DATA_SOURCE_HPP*/
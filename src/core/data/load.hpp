@@ -1,107 +1,658 @@
 #ifndef CORE_DATA_LOAD_HPP
 #define CORE_DATA_LOAD_HPP
 #include "../../prereqs.hpp"
+#include "./mapped_file.hpp"
 
 namespace openml {
 namespace data {
 
 /**
- * load dataset from a txt file
+ * Statistics of a loading call, used to track the parsing throughput.
+ *
+ * @param num_bytes  size of the input file in bytes
+ * @param num_rows  number of non-empty lines parsed
+ * @param num_cols  number of values in each line
+ * @param num_threads  number of threads used to parse
+ * @param elapsed  wall-clock seconds spent from mapping to the last value
+ * @param throughput  parsing throughput in MB/s
+*/
+struct LoadStats {
+    std::size_t num_bytes = 0;
+    std::size_t num_rows = 0;
+    std::size_t num_cols = 0;
+    std::size_t num_threads = 0;
+    double elapsed = 0.0;
+    double throughput = 0.0;
+};
+
+/**
+ * Byte range [begin, end) of a mapped text file, begin is always
+ * the first character of a line and end is one past a '\n' or
+ * the end of file.
+*/
+using ChunkType = std::pair<std::size_t, std::size_t>;
+
+inline bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * Split a text buffer into line aligned chunks of roughly equal size
+ *
+ * @param buffer the first character of text
+ * @param size number of bytes of buffer
+ * @param num_chunks expected number of chunks, the result may contain
+ *      fewer chunks if the buffer has too few lines
+*/
+inline std::vector<ChunkType> split_lines(const char* buffer,
+    std::size_t size,
+    std::size_t num_chunks) {
+
+    std::vector<ChunkType> chunks;
+    std::size_t begin = 0;
+    for (std::size_t i = 1; i <= num_chunks && begin < size; ++i) {
+        std::size_t end = (i == num_chunks) ? size : (size / num_chunks) * i;
+        if (end <= begin) {
+            continue;
+        }
+        // move the boundary to the start of the next line
+        if (end < size) {
+            const void* eol = std::memchr(buffer + end - 1, '\n', size - end + 1);
+            end = (eol == nullptr) ? size :
+                static_cast<std::size_t>(static_cast<const char*>(eol) - buffer) + 1;
+        }
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+    return chunks;
+};
+
+/**
+ * Count the number of values in a line, [first, last) must not contain '\n'
+*/
+inline std::size_t count_tokens(const char* first, const char* last) {
+    std::size_t num_tokens = 0;
+    while (first != last) {
+        while (first != last && is_separator(*first)) {
+            ++first;
+        }
+        if (first == last) {
+            break;
+        }
+        ++num_tokens;
+        while (first != last && !is_separator(*first)) {
+            ++first;
+        }
+    }
+    return num_tokens;
+};
+
+/**
+ * Call func(first, last) for each non-empty line of [first, last),
+ * the '\n' and trailing '\r' characters are not included in the range.
+*/
+template<typename Function>
+void for_each_line(const char* first, const char* last, Function&& func) {
+    while (first < last) {
+        const void* eol = std::memchr(first, '\n', last - first);
+        const char* line_end = (eol == nullptr) ? last : static_cast<const char*>(eol);
+        const char* cursor = first;
+        while (cursor != line_end && is_separator(*cursor)) {
+            ++cursor;
+        }
+        if (cursor != line_end) {
+            func(cursor, line_end);
+        }
+        first = line_end + 1;
+    }
+};
+
+/**
+ * Parse the next value of a line with std::from_chars
+ *
+ * @param first pointer to the current position, it is moved past the parsed value
+ * @param last end of line
+ * @param value output parsed value
+ * @return false if no value is left in the line, throw if the token
+ *      is not a valid number
+*/
+template<typename DataType>
+bool parse_next(const char*& first, const char* last, DataType& value) {
+    while (first != last && is_separator(*first)) {
+        ++first;
+    }
+    if (first == last) {
+        return false;
+    }
+    // std::from_chars does not accept the leading plus sign
+    if (*first == '+') {
+        ++first;
+    }
+    auto result = std::from_chars(first, last, value);
+    if (result.ec != std::errc() ||
+        (result.ptr != last && !is_separator(*result.ptr))) {
+        const char* token_end = first;
+        while (token_end != last && !is_separator(*token_end)) {
+            ++token_end;
+        }
+        std::ostringstream err_msg;
+        err_msg << "Could not parse value '" << std::string(first, token_end)
+                << "'." << std::endl;
+        throw std::invalid_argument(err_msg.str());
+    }
+    first = result.ptr;
+    return true;
+};
+
+/**
+ * Run func(chunk_index, chunk) for each chunk on its own thread,
+ * the first exception thrown by a worker is rethrown in the caller.
+*/
+template<typename Function>
+void parallel_chunks(const std::vector<ChunkType>& chunks, Function&& func) {
+    std::size_t num_chunks = chunks.size();
+    std::vector<std::exception_ptr> errors(num_chunks);
+    std::vector<std::thread> workers;
+    workers.reserve(num_chunks);
+    for (std::size_t i = 1; i < num_chunks; ++i) {
+        workers.emplace_back([&, i]() {
+            try {
+                func(i, chunks[i]);
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    // the calling thread works on the first chunk
+    if (num_chunks > 0) {
+        try {
+            func(0, chunks[0]);
+        }
+        catch (...) {
+            errors[0] = std::current_exception();
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+/**
+ * Choose the number of parsing threads, small files are not worth
+ * spawning threads, we keep at least 1MB of text per thread.
+*/
+inline std::size_t get_num_threads(std::size_t num_bytes,
+    std::size_t num_threads) {
+
+    const std::size_t min_chunk_bytes = 1 << 20;
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    std::size_t max_threads = std::max<std::size_t>(1, num_bytes / min_chunk_bytes);
+    return std::min(num_threads, max_threads);
+};
+
+inline void update_stats(LoadStats& stats,
+    std::chrono::steady_clock::time_point start) {
+
+    auto stop = std::chrono::steady_clock::now();
+    stats.elapsed = std::chrono::duration<double>(stop - start).count();
+    stats.throughput = (stats.elapsed > 0.0) ?
+        static_cast<double>(stats.num_bytes) / 1e6 / stats.elapsed : 0.0;
+};
+
+/**
+ * Parse a text file of fixed length rows. The file is memory mapped, split
+ * into line aligned chunks and each chunk is parsed on its own thread.
+ * A first pass counts the rows of each chunk so that every thread knows the
+ * first row it writes, then values are written straight into the output.
+ *
+ * @param fp String the given filepath
+ * @param num_threads number of parsing threads, 0 means all hardware threads
+ * @param allocate callable allocate(num_rows, num_cols) to resize the outputs
+ * @param store callable store(row, col, value) to write a parsed value
+*/
+template<typename DataType, typename Allocator, typename Writer>
+LoadStats load_dense(const std::string &fp,
+    std::size_t num_threads,
+    Allocator&& allocate,
+    Writer&& store) {
+
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file(fp);
+    const char* buffer = file.data();
+    std::size_t num_bytes = file.size();
+
+    LoadStats stats;
+    stats.num_bytes = num_bytes;
+    stats.num_threads = get_num_threads(num_bytes, num_threads);
+    std::vector<ChunkType> chunks = split_lines(buffer, num_bytes, stats.num_threads);
+
+    std::vector<std::size_t> chunk_rows(chunks.size() + 1, 0);
+    parallel_chunks(chunks, [&](std::size_t i, const ChunkType& chunk) {
+        std::size_t count = 0;
+        for_each_line(buffer + chunk.first, buffer + chunk.second,
+            [&](const char*, const char*) { ++count; });
+        chunk_rows[i + 1] = count;
+    });
+    std::partial_sum(chunk_rows.begin(), chunk_rows.end(), chunk_rows.begin());
+
+    std::size_t num_rows = chunk_rows.back(), num_cols = 0;
+    if (num_rows == 0) {
+        throw std::runtime_error("Input file is empty.");
+    }
+    // number of values is given by the first non-empty line
+    for (const char* first = buffer; num_cols == 0; ) {
+        const void* eol = std::memchr(first, '\n', buffer + num_bytes - first);
+        const char* line_end = (eol == nullptr) ? buffer + num_bytes : static_cast<const char*>(eol);
+        num_cols = count_tokens(first, line_end);
+        first = line_end + 1;
+    }
+    stats.num_rows = num_rows;
+    stats.num_cols = num_cols;
+    allocate(num_rows, num_cols);
+
+    parallel_chunks(chunks, [&](std::size_t i, const ChunkType& chunk) {
+        std::size_t row = chunk_rows[i];
+        for_each_line(buffer + chunk.first, buffer + chunk.second,
+            [&](const char* first, const char* last) {
+                DataType value;
+                std::size_t col = 0;
+                while (col < num_cols && parse_next(first, last, value)) {
+                    store(row, col, value);
+                    ++col;
+                }
+                if (col != num_cols || parse_next(first, last, value)) {
+                    std::ostringstream err_msg;
+                    err_msg << "Row " << row << " does not have "
+                            << num_cols << " values." << std::endl;
+                    throw std::invalid_argument(err_msg.str());
+                }
+                ++row;
+            });
+    });
+    update_stats(stats, start);
+    return stats;
+};
+
+/**
+ * load dataset from a txt file, the last column of each line is the label.
+ * Values are parsed in parallel and written directly into X and y.
+ *
  * @param fp String the given filepath 
  * @param X 2d-array of shape (num_samples, num_features) the output matrix 
  * @param y 2d-array of shape (num_samples, 1) the output label matrix 
+ * @param num_threads number of parsing threads, default 0 means using
+ *      all hardware threads
+ * @return LoadStats the parsing statistics, including throughput in MB/s
 */
 template<typename MatType, 
     typename VecType,
     typename DataType = typename MatType::value_type>
-void loadtxt(const std::string &fp, 
+LoadStats loadtxt(const std::string &fp, 
     MatType& X, 
-    VecType& y) {
+    VecType& y,
+    std::size_t num_threads = 0) {
 
-    std::vector<std::vector<DataType>> stdmat;
-    std::ifstream fin(fp);
-    if(!fin) {
-        throw std::runtime_error("Input file could not be opened.");
-        exit(0);
-    }
-    for (std::string line; std::getline(fin, line); ) {
-        std::stringstream str_stream(line);
-        std::vector<DataType> row;
+    std::size_t num_features = 0;
+    return load_dense<DataType>(fp, num_threads, 
+        [&](std::size_t num_rows, std::size_t num_cols) {
+            if (num_cols < 2) {
+                throw std::runtime_error("Input file needs at least one feature and a label.");
+            }
+            num_features = num_cols - 1;
+            X.resize(num_rows, num_features);
+            y.resize(num_rows, 1);
+        },
+        [&](std::size_t row, std::size_t col, DataType value) {
+            if (col < num_features) {
+                X(row, col) = value;
+            }
+            else {
+                y(row, 0) = value;
+            }
+        });
+};
 
-        for (DataType elem; str_stream >> elem; ) {
-            row.push_back(elem);
-        }
-        stdmat.push_back(row);
-    }
+/**
+ * load a text file of variable length rows, such as transactions,
+ * each line is parsed into a row of X.
+*/
+template<typename DataType>
+LoadStats loadtxt(const std::string &fp,
+    std::vector<std::vector<DataType>>& X,
+    std::size_t num_threads = 0) {
+
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file(fp);
+    const char* buffer = file.data();
+    std::size_t num_bytes = file.size();
+
+    LoadStats stats;
+    stats.num_bytes = num_bytes;
+    stats.num_threads = get_num_threads(num_bytes, num_threads);
+    std::vector<ChunkType> chunks = split_lines(buffer, num_bytes, stats.num_threads);
+
+    // rows have different length, so each thread fills its own
+    // rows which are moved in the output in the chunk order
+    std::vector<std::vector<std::vector<DataType>>> chunk_rows(chunks.size());
+    parallel_chunks(chunks, [&](std::size_t i, const ChunkType& chunk) {
+        for_each_line(buffer + chunk.first, buffer + chunk.second,
+            [&](const char* first, const char* last) {
+                std::vector<DataType> row;
+                row.reserve(count_tokens(first, last));
+                DataType value;
+                while (parse_next(first, last, value)) {
+                    row.push_back(value);
+                }
+                chunk_rows[i].emplace_back(std::move(row));
+            });
+    });
 
-    // conert std 2D vector into eigen matrix
-    std::size_t n_rows = stdmat.size(), n_cols = stdmat[0].size();
-    MatType mat(n_rows, n_cols);
-    for (std::size_t i = 0; i < n_rows; i++) {
-        mat.row(i) = VecType::Map(&stdmat[i][0], n_cols);
+    std::size_t num_rows = 0;
+    for (auto& rows : chunk_rows) {
+        num_rows += rows.size();
     }
-    X = mat.leftCols(n_cols - 1);
-    y = mat.rightCols(1);
-    
+    X.reserve(X.size() + num_rows);
+    for (auto& rows : chunk_rows) {
+        std::move(rows.begin(), rows.end(), std::back_inserter(X));
+    }
+
+    stats.num_rows = num_rows;
+    update_stats(stats, start);
+    return stats;
 };
 
+
+/**
+ * load dataset from a txt file into std 2d vector,
+ * the last column of each line is the label.
+*/
 template<typename DataType>
-void loadtxt(const std::string &fp, 
-    std::vector<std::vector<DataType>>& X) {
+LoadStats loadtxt(const std::string &fp, 
+    std::vector<std::vector<DataType>>& X, 
+    std::vector<DataType>& y,
+    std::size_t num_threads = 0) {
+
+    std::size_t num_features = 0;
+    return load_dense<DataType>(fp, num_threads, 
+        [&](std::size_t num_rows, std::size_t num_cols) {
+            if (num_cols < 2) {
+                throw std::runtime_error("Input file needs at least one feature and a label.");
+            }
+            num_features = num_cols - 1;
+            X.assign(num_rows, std::vector<DataType>(num_features));
+            y.assign(num_rows, DataType());
+        },
+        [&](std::size_t row, std::size_t col, DataType value) {
+            if (col < num_features) {
+                X[row][col] = value;
+            }
+            else {
+                y[row] = value;
+            }
+        });
+};
+
+/**
+ * Parse one line of a LIBSVM/SVMlight file
+ * 
+ *      <label> [qid:<value>] <index>:<value> <index>:<value> ... [# comment]
+ * 
+ * @param first_last range of the line without '\n'
+ * @param label output label of the line
+ * @param qid output query id, -1 if the line has no qid
+ * @param on_feature callable on_feature(index, value_first, value_last), 
+ *      values are given as text so the counting pass does not parse them
+ * @return false if the line holds only a comment, it must be skipped
+*/
+template<typename DataType, typename Function>
+bool parse_svmlight_line(const char* first, 
+    const char* last, 
+    DataType& label, 
+    long long& qid,
+    Function&& on_feature) {
     
-    std::ifstream fin(fp);
-    if(!fin) {
-        throw std::runtime_error("Input file could not be opened.");
-        exit(0);
+    const void* comment = std::memchr(first, '#', last - first);
+    if (comment != nullptr) {
+        last = static_cast<const char*>(comment);
+        while (first != last && is_separator(*first)) {
+            ++first;
+        }
+        if (first == last) {
+            return false;
+        }
     }
-    for (std::string line; std::getline(fin, line); ) {
-        std::stringstream str_stream(line);
-        std::vector<DataType> row;
-
-        for (DataType elem; str_stream >> elem; ) {
-            row.push_back(elem);
+    if (!parse_next(first, last, label)) {
+        throw std::invalid_argument("Line of svmlight file has no label.");
+    }
+    qid = -1;
+    while (true) {
+        while (first != last && is_separator(*first)) {
+            ++first;
+        }
+        if (first == last) {
+            break;
         }
-        X.push_back(row);
+        const char* token_end = first;
+        while (token_end != last && !is_separator(*token_end)) {
+            ++token_end;
+        }
+        const char* colon = static_cast<const char*>(std::memchr(first, ':', token_end - first));
+        if (colon == nullptr) {
+            std::ostringstream err_msg;
+            err_msg << "Invalid svmlight token '" << std::string(first, token_end) 
+                    << "', expected <index>:<value>." << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (colon - first == 3 && std::strncmp(first, "qid", 3) == 0) {
+            auto result = std::from_chars(colon + 1, token_end, qid);
+            if (result.ec != std::errc() || result.ptr != token_end) {
+                throw std::invalid_argument("Invalid qid value in svmlight file.");
+            }
+        }
+        else {
+            long long index;
+            auto result = std::from_chars(first, colon, index);
+            if (result.ec != std::errc() || result.ptr != colon || index < 0) {
+                std::ostringstream err_msg;
+                err_msg << "Invalid feature index '" << std::string(first, colon) 
+                        << "'." << std::endl;
+                throw std::invalid_argument(err_msg.str());
+            }
+            on_feature(index, colon + 1, token_end);
+        }
+        first = token_end;
     }
+    return true;
 };
 
-
 /**
+ * load a sparse dataset of LIBSVM/SVMlight format into a CSR matrix. The file 
+ * is memory mapped and parsed in parallel by line aligned chunks. A first pass 
+ * counts the rows and non-zeros of each chunk, then every thread writes its 
+ * rows directly into the CSR arrays of X, no triplet list is built.
  * 
+ * @param fp String the given filepath 
+ * @param X sparse matrix of shape (num_samples, num_features), must be RowMajor
+ * @param y vector of shape (num_samples, 1) the output label 
+ * @param qid optional pointer to the output query id vector, -1 for rows without qid
+ * @param num_features number of features, 0 means inferring it from the max index
+ * @param zero_based bool, whether feature indices start at 0, default false 
+ *      since LIBSVM indices start at 1
+ * @param num_threads number of parsing threads, 0 means using all hardware threads
+ * @return LoadStats the parsing statistics, num_cols is the number of features
 */
-template<typename DataType>
-void loadtxt(const std::string &fp, 
-    std::vector<std::vector<DataType>>& X, 
-    std::vector<DataType>& y) {
+template<typename SpMatType, 
+    typename VecType, 
+    typename IdxVecType,
+    typename DataType = typename SpMatType::Scalar>
+LoadStats load_svmlight(const std::string &fp, 
+    SpMatType& X, 
+    VecType& y, 
+    IdxVecType* qid,
+    std::size_t num_features = 0,
+    bool zero_based = false,
+    std::size_t num_threads = 0) {
     
-    std::ifstream fin(fp);
-    if(!fin) {
-        throw std::runtime_error("Input file could not be opened.");
-        exit(0);
-    }
+    static_assert(SpMatType::IsRowMajor, "load_svmlight builds a RowMajor (CSR) matrix.");
+    using StorageIndex = typename SpMatType::StorageIndex;
 
-    std::vector<std::vector<DataType>> stdmat;
-    for (std::string line; std::getline(fin, line); ) {
-        std::stringstream str_stream(line);
-        std::vector<DataType> row;
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file(fp);
+    const char* buffer = file.data();
+    std::size_t num_bytes = file.size();
 
-        for (DataType elem; str_stream >> elem; ) {
-            row.push_back(elem);
-        }
-        stdmat.push_back(row);
+    LoadStats stats;
+    stats.num_bytes = num_bytes;
+    stats.num_threads = get_num_threads(num_bytes, num_threads);
+    std::vector<ChunkType> chunks = split_lines(buffer, num_bytes, stats.num_threads);
+    std::size_t num_chunks = chunks.size();
+    long long offset = zero_based ? 0 : 1;
+
+    // first pass: rows, non-zeros and max feature index of each chunk
+    std::vector<std::size_t> chunk_rows(num_chunks + 1, 0);
+    std::vector<std::size_t> chunk_nnz(num_chunks + 1, 0);
+    std::vector<long long> chunk_max_index(num_chunks, -1);
+    parallel_chunks(chunks, [&](std::size_t i, const ChunkType& chunk) {
+        std::size_t num_rows = 0, nnz = 0;
+        long long max_index = -1;
+        for_each_line(buffer + chunk.first, buffer + chunk.second, 
+            [&](const char* first, const char* last) {
+                DataType label;
+                long long row_qid;
+                bool has_row = parse_svmlight_line(first, last, label, row_qid, 
+                    [&](long long index, const char*, const char*) {
+                        if (index < offset) {
+                            throw std::invalid_argument(
+                                "Feature index 0 found in a one-based svmlight file."
+                            );
+                        }
+                        max_index = std::max(max_index, index - offset);
+                        ++nnz;
+                    });
+                if (has_row) {
+                    ++num_rows;
+                }
+            });
+        chunk_rows[i + 1] = num_rows;
+        chunk_nnz[i + 1] = nnz;
+        chunk_max_index[i] = max_index;
+    });
+    std::partial_sum(chunk_rows.begin(), chunk_rows.end(), chunk_rows.begin());
+    std::partial_sum(chunk_nnz.begin(), chunk_nnz.end(), chunk_nnz.begin());
+
+    std::size_t num_rows = chunk_rows.back(), nnz = chunk_nnz.back();
+    if (num_rows == 0) {
+        throw std::runtime_error("Input file is empty.");
+    }
+    long long max_index = *std::max_element(chunk_max_index.begin(), chunk_max_index.end());
+    if (num_features == 0) {
+        num_features = static_cast<std::size_t>(max_index + 1);
+    }
+    else if (max_index >= static_cast<long long>(num_features)) {
+        std::ostringstream err_msg;
+        err_msg << "Feature index " << max_index + offset << " is out of range, "
+                << "num_features = " << num_features << std::endl;
+        throw std::invalid_argument(err_msg.str());
     }
 
-    std::size_t nrows = stdmat.size(), ncols = stdmat[0].size();
-    X.resize(nrows, std::vector<DataType>(ncols - 1));
-    for (std::size_t i = 0; i < nrows; ++i) {
-        for (std::size_t j = 0; j < ncols - 1; ++j) {
-            X[i][j] = stdmat[i][j];
-        }
-        y.emplace_back(stdmat[i].back());
+    // allocate the compressed storage and write it directly
+    X.resize(num_rows, num_features);
+    X.resizeNonZeros(nnz);
+    y.resize(num_rows);
+    if (qid != nullptr) {
+        qid->resize(num_rows);
     }
-};
+    StorageIndex* outer = X.outerIndexPtr();
+    StorageIndex* inner = X.innerIndexPtr();
+    DataType* values = X.valuePtr();
+    outer[num_rows] = static_cast<StorageIndex>(nnz);
 
+    parallel_chunks(chunks, [&](std::size_t i, const ChunkType& chunk) {
+        std::size_t row = chunk_rows[i], pos = chunk_nnz[i];
+        std::vector<std::pair<StorageIndex, DataType>> unsorted;
+        for_each_line(buffer + chunk.first, buffer + chunk.second, 
+            [&](const char* first, const char* last) {
+                std::size_t row_start = pos;
+                bool sorted = true;
+                DataType label;
+                long long row_qid;
+                bool has_row = parse_svmlight_line(first, last, label, row_qid, 
+                    [&](long long index, const char* value_first, const char* value_last) {
+                        DataType value;
+                        if (!parse_next(value_first, value_last, value) || value_first != value_last) {
+                            throw std::invalid_argument("Invalid feature value in svmlight file.");
+                        }
+                        inner[pos] = static_cast<StorageIndex>(index - offset);
+                        values[pos] = value;
+                        if (pos > row_start && inner[pos] <= inner[pos - 1]) {
+                            sorted = false;
+                        }
+                        ++pos;
+                    });
+                if (!has_row) {
+                    return ;
+                }
+                outer[row] = static_cast<StorageIndex>(row_start);
+                // LIBSVM requires ascending indices, but be lenient 
+                // with unsorted rows, duplicates are rejected
+                if (!sorted) {
+                    unsorted.clear();
+                    for (std::size_t k = row_start; k < pos; ++k) {
+                        unsorted.emplace_back(inner[k], values[k]);
+                    }
+                    std::sort(unsorted.begin(), unsorted.end(), 
+                        [](const auto& a, const auto& b) { return a.first < b.first; });
+                    for (std::size_t k = row_start; k < pos; ++k) {
+                        inner[k] = unsorted[k - row_start].first;
+                        values[k] = unsorted[k - row_start].second;
+                        if (k > row_start && inner[k] == inner[k - 1]) {
+                            std::ostringstream err_msg;
+                            err_msg << "Duplicate feature index " << inner[k] + offset
+                                    << " in row " << row << std::endl;
+                            throw std::invalid_argument(err_msg.str());
+                        }
+                    }
+                }
+                y[row] = label;
+                if (qid != nullptr) {
+                    (*qid)[row] = row_qid;
+                }
+                ++row;
+            });
+    });
 
+    stats.num_rows = num_rows;
+    stats.num_cols = num_features;
+    update_stats(stats, start);
+    return stats;
+};
+
+/**
+ * load a sparse dataset of LIBSVM/SVMlight format without query id
+*/
+template<typename SpMatType, 
+    typename VecType,
+    typename DataType = typename SpMatType::Scalar>
+LoadStats load_svmlight(const std::string &fp, 
+    SpMatType& X, 
+    VecType& y, 
+    std::size_t num_features = 0,
+    bool zero_based = false,
+    std::size_t num_threads = 0) {
+    
+    using IdxVecType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, 1>;
+    return load_svmlight<SpMatType, VecType, IdxVecType>(
+        fp, X, y, nullptr, num_features, zero_based, num_threads
+    );
+};
 
 }
 }
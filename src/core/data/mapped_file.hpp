@@ -0,0 +1,119 @@
+#ifndef CORE_DATA_MAPPED_FILE_HPP
+#define CORE_DATA_MAPPED_FILE_HPP
+#include "../../prereqs.hpp"
+
+namespace openml {
+namespace data {
+
+/**
+ * Read-only memory mapping of a whole file. The mapping is released
+ * when the object goes out of scope, the object can be moved but not copied.
+ *
+ * @param fp String the given filepath
+*/
+class MappedFile {
+private:
+    int fd_;
+    std::size_t size_;
+    void* addr_;
+
+    void release() {
+        if (addr_ != nullptr) {
+            ::munmap(addr_, size_);
+            addr_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        size_ = 0;
+    }
+
+public:
+    MappedFile(): fd_(-1), size_(0), addr_(nullptr) {};
+
+    explicit MappedFile(const std::string& fp): fd_(-1), size_(0), addr_(nullptr) {
+        open(fp);
+    };
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept: fd_(other.fd_),
+        size_(other.size_),
+        addr_(other.addr_) {
+        other.fd_ = -1;
+        other.size_ = 0;
+        other.addr_ = nullptr;
+    };
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            std::swap(fd_, other.fd_);
+            std::swap(size_, other.size_);
+            std::swap(addr_, other.addr_);
+        }
+        return *this;
+    };
+
+    ~MappedFile() {
+        release();
+    };
+
+    /**
+     * map the given file into memory, the previous mapping is released
+    */
+    void open(const std::string& fp) {
+        release();
+        fd_ = ::open(fp.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            throw std::runtime_error("Input file could not be opened.");
+        }
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            release();
+            throw std::runtime_error("Could not get the size of input file.");
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+
+        // mmap does not accept zero length mapping, an empty file
+        // is kept as a valid object with size 0 and a null address
+        if (size_ == 0) {
+            return ;
+        }
+
+        addr_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (addr_ == MAP_FAILED) {
+            addr_ = nullptr;
+            release();
+            std::ostringstream err_msg;
+            err_msg << "Memory mapping of input file failed: "
+                    << std::strerror(errno) << std::endl;
+            throw std::runtime_error(err_msg.str());
+        }
+        // file is mostly read front to back
+        ::madvise(addr_, size_, MADV_SEQUENTIAL);
+    }
+
+    void close() {
+        release();
+    }
+
+    const char* data() const {
+        return static_cast<const char*>(addr_);
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool is_open() const {
+        return fd_ >= 0;
+    }
+};
+
+}
+}
+#endif /*CORE_DATA_MAPPED_FILE_HPP*/
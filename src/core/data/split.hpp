@@ -15,6 +15,8 @@ namespace data {
  * @param train_size float, should be between 0.0 and 1.0 and represent the 
  *                   proportion of the dataset to include in the train split
  * @param shuffle bool, Whether or not to shuffle the data before splitting.
+ * @param random_state long, seed of the shuffle, default -1 means
+ *                   the generator is taken from the global seed
  * 
  * @return a tuple contains X_train, X_test, y_train, y_test matrix
 */
@@ -22,7 +24,8 @@ template<typename MatType, typename VecType>
 std::tuple<MatType, MatType, VecType, VecType> train_test_split(const MatType& X, 
         const VecType& y,
         double train_size = 0.75, 
-        bool shuffle = true) {
+        bool shuffle = true,
+        long random_state = -1) {
     
     std::size_t num_samples = X.rows(), num_features = X.cols();
 
@@ -30,7 +33,7 @@ std::tuple<MatType, MatType, VecType, VecType> train_test_split(const MatType& X
     VecType new_y = y;
 
     if (shuffle) {
-        random::shuffle_data<MatType, VecType>(X, y, new_X, new_y);
+        random::shuffle_data<MatType, VecType>(X, y, new_X, new_y, random_state);
     }
 
     int num_train_samples = num_samples * train_size;
@@ -133,6 +133,9 @@ std::tuple<MatType, VecType, MatType> exact_svd(const MatType& x,
  * @param power_iter_nomalizer string
  *      Whether the power iterations are normalized with step-by-step
  *      it has 3 value: 'QR', 'LU', 'None'
+ * @param random_state long
+ *      Seed of the random matrix, default -1 means the 
+ *      generator is taken from the global seed
  * @return a tuple contains U matrix, s vector and Vt matrix.
 */
 template<typename MatType, typename VecType, typename IdxVecType>
@@ -141,7 +144,8 @@ std::tuple<MatType, VecType, MatType> randomized_svd(const MatType& X,
     std::size_t num_oversamples = 10,
     std::size_t num_iters = 4, 
     std::string power_iter_normalizer = "LU", 
-    bool flip_sign = true) {
+    bool flip_sign = true, 
+    long random_state = -1) {
     
     std::size_t num_samples = X.rows(), num_features = X.cols();
     std::size_t num_random = num_components + num_oversamples;
@@ -155,7 +159,8 @@ std::tuple<MatType, VecType, MatType> randomized_svd(const MatType& X,
     }
 
     // init a random matrix Q
-    MatType Q = random::randn<MatType>(num_features, num_random);
+    random::Philox4x32 generator = random::make_generator(random_state);
+    MatType Q = random::randn<MatType>(num_features, num_random, 0.0, 1.0, generator);
     for (std::size_t i = 0; i < num_iters; ++i) {
 
         if (power_iter_normalizer == "None") {
@@ -6,101 +6,444 @@ namespace openml {
 namespace random {
 
 /**
- * Create an array of the given shape and populate it with random 
- * samples from a uniform distribution over
+ * Philox4x32-10 counter-based random number generator,
+ * "Parallel random numbers: as easy as 1, 2, 3", Salmon et al. 2011.
+ *
+ * Each block of 4 outputs is a pure function of the key and the counter,
+ * the 64-bit seed is the key, the counter is made of a 64-bit block index
+ * and a 64-bit stream id. Generators with the same seed and different
+ * streams are independent, and any block of a stream can be computed
+ * directly, so that a large array can be filled by several threads with
+ * exactly the same values as a serial fill.
+ *
+ * It satisfies UniformRandomBitGenerator and can be used with std distributions.
+ *
+ * @param seed uint64 the key of generator
+ * @param stream uint64 the stream id
 */
-template<typename MatType, 
+class Philox4x32 {
+public:
+    using result_type = std::uint32_t;
+    using BlockType = std::array<std::uint32_t, 4>;
+
+private:
+    static constexpr std::uint32_t MULTIPLIER0 = 0xD2511F53;
+    static constexpr std::uint32_t MULTIPLIER1 = 0xCD9E8D57;
+    static constexpr std::uint32_t WEYL0 = 0x9E3779B9;
+    static constexpr std::uint32_t WEYL1 = 0xBB67AE85;
+
+    std::uint64_t seed_;
+    std::uint64_t stream_;
+    // index of the next block to generate
+    std::uint64_t block_;
+    BlockType output_;
+    // number of consumed outputs of the current block
+    std::size_t pos_;
+
+public:
+    Philox4x32(): Philox4x32(0, 0) {};
+
+    explicit Philox4x32(std::uint64_t seed,
+        std::uint64_t stream = 0): seed_(seed),
+            stream_(stream),
+            block_(0),
+            output_{},
+            pos_(4) {};
+
+    ~Philox4x32() {};
+
+    /**
+     * compute the block of the given stream and index with 10 rounds
+    */
+    static BlockType generate(std::uint64_t seed,
+        std::uint64_t stream,
+        std::uint64_t block) {
+
+        std::uint32_t c0 = static_cast<std::uint32_t>(block);
+        std::uint32_t c1 = static_cast<std::uint32_t>(block >> 32);
+        std::uint32_t c2 = static_cast<std::uint32_t>(stream);
+        std::uint32_t c3 = static_cast<std::uint32_t>(stream >> 32);
+        std::uint32_t k0 = static_cast<std::uint32_t>(seed);
+        std::uint32_t k1 = static_cast<std::uint32_t>(seed >> 32);
+
+        for (int round = 0; round < 10; ++round) {
+            std::uint64_t prod0 = static_cast<std::uint64_t>(MULTIPLIER0) * c0;
+            std::uint64_t prod1 = static_cast<std::uint64_t>(MULTIPLIER1) * c2;
+            std::uint32_t hi0 = static_cast<std::uint32_t>(prod0 >> 32);
+            std::uint32_t hi1 = static_cast<std::uint32_t>(prod1 >> 32);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = static_cast<std::uint32_t>(prod1);
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = static_cast<std::uint32_t>(prod0);
+            k0 += WEYL0;
+            k1 += WEYL1;
+        }
+        return BlockType{c0, c1, c2, c3};
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ConstType<result_type>::max();
+    }
+
+    result_type operator()() {
+        if (pos_ == 4) {
+            output_ = generate(seed_, stream_, block_++);
+            pos_ = 0;
+        }
+        return output_[pos_++];
+    }
+
+    /**
+     * return 64 random bits made of 2 outputs
+    */
+    std::uint64_t next_uint64() {
+        std::uint64_t hi = (*this)();
+        std::uint64_t lo = (*this)();
+        return (hi << 32) | lo;
+    }
+
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+        seed_ = seed;
+        stream_ = stream;
+        block_ = 0;
+        pos_ = 4;
+    }
+
+    void discard(unsigned long long n) {
+        std::size_t remain = 4 - pos_;
+        if (n <= remain) {
+            pos_ += n;
+            return ;
+        }
+        n -= remain;
+        block_ += n / 4;
+        pos_ = 4;
+        if (n % 4 != 0) {
+            output_ = generate(seed_, stream_, block_++);
+            pos_ = n % 4;
+        }
+    }
+
+    /**
+     * reserve a range of num_blocks fresh blocks for a bulk generation,
+     * return the index of the first block, the unused outputs of the
+     * current block are dropped.
+    */
+    std::uint64_t reserve_blocks(std::uint64_t num_blocks) {
+        std::uint64_t first = block_;
+        block_ += num_blocks;
+        pos_ = 4;
+        return first;
+    }
+
+    /**
+     * create an independent generator, e.g. for a thread or a task,
+     * the key is derived from this generator and the stream is the given id,
+     * so substreams of substreams remain distinct.
+    */
+    Philox4x32 substream(std::uint64_t stream) const {
+        // splitmix64 finalizer to derive a new key
+        std::uint64_t key = seed_ + 0x9E3779B97F4A7C15ULL * (stream_ + 1);
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+        key = key ^ (key >> 31);
+        return Philox4x32(key, stream);
+    }
+
+    std::uint64_t get_seed() const {
+        return seed_;
+    }
+
+    std::uint64_t get_stream() const {
+        return stream_;
+    }
+};
+
+/**
+ * global seed and stream counter, each call of random functions without
+ * an explicit generator takes a new stream of the global seed, the results
+ * are reproducible once the global seed is set, if it is never set,
+ * the seed comes from std::random_device.
+*/
+inline std::atomic<std::uint64_t>& global_seed() {
+    static std::atomic<std::uint64_t> seed{[]() {
+        std::random_device rand;
+        return (static_cast<std::uint64_t>(rand()) << 32) | rand();
+    }()};
+    return seed;
+};
+
+inline std::atomic<std::uint64_t>& global_stream() {
+    static std::atomic<std::uint64_t> stream{0};
+    return stream;
+};
+
+/**
+ * set the global seed and restart the global stream counter
+*/
+inline void seed(std::uint64_t value) {
+    global_seed().store(value);
+    global_stream().store(0);
+};
+
+inline Philox4x32 global_generator() {
+    return Philox4x32(global_seed().load(), global_stream().fetch_add(1));
+};
+
+/**
+ * create the generator of an estimator
+ * @param random_state long, a non-negative value is used as seed,
+ *      a negative value means the generator is taken from the global seed
+*/
+inline Philox4x32 make_generator(long random_state) {
+    if (random_state < 0) {
+        return global_generator();
+    }
+    return Philox4x32(static_cast<std::uint64_t>(random_state));
+};
+
+/**
+ * number of threads for generating num_blocks blocks,
+ * each thread generates at least 32768 blocks
+*/
+inline std::size_t get_num_threads(std::size_t num_blocks, std::size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    std::size_t max_threads = std::max<std::size_t>(num_blocks / 32768, 1);
+    return std::min(num_threads, max_threads);
+};
+
+/**
+ * generate num_blocks consecutive blocks of the generator, the block i is
+ * passed to func(i, block). Blocks are split into contiguous ranges
+ * among threads, the result does not depend on the number of threads.
+*/
+template<typename Function>
+void generate_blocks(Philox4x32& generator,
+    std::size_t num_blocks,
+    std::size_t num_threads,
+    Function&& func) {
+
+    std::uint64_t seed = generator.get_seed(), stream = generator.get_stream();
+    std::uint64_t first = generator.reserve_blocks(num_blocks);
+    auto run = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            func(i, Philox4x32::generate(seed, stream, first + i));
+        }
+    };
+
+    num_threads = get_num_threads(num_blocks, num_threads);
+    if (num_threads <= 1) {
+        run(0, num_blocks);
+        return ;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    std::size_t step = (num_blocks + num_threads - 1) / num_threads;
+    for (std::size_t begin = 0; begin < num_blocks; begin += step) {
+        threads.emplace_back(run, begin, std::min(begin + step, num_blocks));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+};
+
+/**
+ * map 64 random bits to a uniform value over [0, 1)
+*/
+template<typename DataType>
+DataType uniform_real(std::uint64_t bits) {
+    if (std::is_same<DataType, float>::value) {
+        return static_cast<DataType>(bits >> 40) * (1.0f / 16777216.0f);
+    }
+    return static_cast<DataType>(static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0));
+};
+
+/**
+ * return a uniform integer over [0, bound) without modulo bias
+*/
+inline std::uint64_t uniform_index(Philox4x32& generator, std::uint64_t bound) {
+    std::uint64_t threshold = (0 - bound) % bound;
+    while (true) {
+        std::uint64_t bits = generator.next_uint64();
+        if (bits >= threshold) {
+            return bits % bound;
+        }
+    }
+};
+
+/**
+ * Fisher-Yates shuffle of a sequence, unlike std::shuffle the
+ * result only depends on the generator and not on the std library
+*/
+template<typename RandomIt>
+void shuffle(RandomIt first, RandomIt last, Philox4x32& generator) {
+    std::size_t size = static_cast<std::size_t>(std::distance(first, last));
+    for (std::size_t i = size; i > 1; --i) {
+        std::size_t j = static_cast<std::size_t>(uniform_index(generator, i));
+        std::iter_swap(first + (i - 1), first + j);
+    }
+};
+
+/**
+ * Create an array of the given shape and populate it with random
+ * samples from a uniform distribution over [low, high)
+ *
+ * @param generator the random generator, it is advanced past the used blocks
+ * @param num_threads number of threads, 0 means hardware concurrency
+*/
+template<typename MatType,
     typename DataType = typename MatType::value_type>
-MatType rand(std::size_t nrows, std::size_t ncols, 
-    DataType low = 0.0, 
-    DataType high = 1.0) {
-    
-    std::random_device rand;
-    std::mt19937 generator(rand());  //here set the seed
-    std::uniform_real_distribution<DataType> dist{low, high};
-
-    MatType rand_mat = MatType::NullaryExpr(
-        nrows, ncols, [&](){
-            return dist(generator);
+MatType rand(std::size_t nrows, std::size_t ncols,
+    DataType low,
+    DataType high,
+    Philox4x32& generator,
+    std::size_t num_threads = 0) {
+
+    MatType rand_mat(nrows, ncols);
+    DataType* data = rand_mat.data();
+    std::size_t size = nrows * ncols;
+    // a block of 4 outputs gives 2 values of 64 bits
+    generate_blocks(generator, (size + 1) / 2, num_threads,
+        [&](std::size_t i, const Philox4x32::BlockType& block) {
+            std::uint64_t bits[2] = {
+                (static_cast<std::uint64_t>(block[0]) << 32) | block[1],
+                (static_cast<std::uint64_t>(block[2]) << 32) | block[3]
+            };
+            for (std::size_t k = 0; k < 2 && 2 * i + k < size; ++k) {
+                data[2 * i + k] = low + (high - low) * uniform_real<DataType>(bits[k]);
+            }
         }
     );
     return rand_mat;
 };
 
+template<typename MatType,
+    typename DataType = typename MatType::value_type>
+MatType rand(std::size_t nrows, std::size_t ncols,
+    DataType low = 0.0,
+    DataType high = 1.0) {
+
+    Philox4x32 generator = global_generator();
+    return rand<MatType, DataType>(nrows, ncols, low, high, generator);
+};
+
 
 /**
- * with random floats sampled from a univariate 
- * Gaussian distribution of mean 0 and variance 1
+ * with random floats sampled from a univariate Gaussian distribution
+ * of the given mean and standard deviation, default mean 0 and variance 1,
+ * Box-Muller transform gives 2 values for each block.
 */
-template<typename MatType, 
+template<typename MatType,
     typename DataType = typename MatType::value_type>
-MatType randn(std::size_t nrows, std::size_t ncols, 
-    DataType low = 0.0, 
-    DataType high = 1.0) {
-    
-    std::random_device rand;
-    std::mt19937 generator(rand());  //here set the seed
-    std::normal_distribution<DataType> dist{low, high};
-
-    MatType rand_mat = MatType::NullaryExpr(
-        nrows, ncols, [&](){
-            return dist(generator);
+MatType randn(std::size_t nrows, std::size_t ncols,
+    DataType mean,
+    DataType stddev,
+    Philox4x32& generator,
+    std::size_t num_threads = 0) {
+
+    MatType rand_mat(nrows, ncols);
+    DataType* data = rand_mat.data();
+    std::size_t size = nrows * ncols;
+    generate_blocks(generator, (size + 1) / 2, num_threads,
+        [&](std::size_t i, const Philox4x32::BlockType& block) {
+            // u1 over (0, 1] to avoid log(0), u2 over [0, 1)
+            double u1 = 1.0 - uniform_real<double>((static_cast<std::uint64_t>(block[0]) << 32) | block[1]);
+            double u2 = uniform_real<double>((static_cast<std::uint64_t>(block[2]) << 32) | block[3]);
+            double radius = std::sqrt(-2.0 * std::log(u1));
+            double values[2] = {
+                radius * std::cos(2.0 * M_PI * u2),
+                radius * std::sin(2.0 * M_PI * u2)
+            };
+            for (std::size_t k = 0; k < 2 && 2 * i + k < size; ++k) {
+                data[2 * i + k] = mean + stddev * static_cast<DataType>(values[k]);
+            }
         }
     );
     return rand_mat;
 };
 
+template<typename MatType,
+    typename DataType = typename MatType::value_type>
+MatType randn(std::size_t nrows, std::size_t ncols,
+    DataType mean = 0.0,
+    DataType stddev = 1.0) {
+
+    Philox4x32 generator = global_generator();
+    return randn<MatType, DataType>(nrows, ncols, mean, stddev, generator);
+};
+
 /**
  * Randomly permute a sequence
- * @param size int  
- *    number of sequence to generate randomly permutation 
+ * @param size int
+ *    number of sequence to generate randomly permutation
 */
 template<typename IdxVecType>
-IdxVecType permutation(const std::size_t size) {
-    std::random_device rand;
-    std::seed_seq seed{rand()};
-
-    //create random engines with the rng seed
-    std::mt19937 generator(seed);
-
-    //create permutation Matrix with the size
-    Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic> permutation(size);
-    permutation.setIdentity();
-
-    std::shuffle(permutation.indices().data(), 
-        permutation.indices().data() + permutation.indices().size(), 
-        generator);
-
-    IdxVecType index;
-    index = permutation.indices().template cast<Eigen::Index>();
+IdxVecType permutation(const std::size_t size, Philox4x32& generator) {
+    IdxVecType index(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        index(i) = i;
+    }
+    shuffle(index.data(), index.data() + size, generator);
     return index;
 };
 
+template<typename IdxVecType>
+IdxVecType permutation(const std::size_t size) {
+    Philox4x32 generator = global_generator();
+    return permutation<IdxVecType>(size, generator);
+};
+
 /**
  * Return random integers from low to high.
  * Return random integers from the discrete uniform distribution
+ * over the closed interval [low, high]
 */
-template<typename DataType, 
+template<typename DataType,
     typename MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>>
-MatType randint(std::size_t nrows, 
-    std::size_t ncols, 
-    DataType low = 0, 
-    DataType high = 1e+2) {
-    
-    std::random_device rand;     // only used once to initialise (seed) engine
-    std::seed_seq seed{rand()};
-
-    std::mt19937 generator(seed);    // random-number engine used (Mersenne-Twister in this case)
-    std::uniform_int_distribution<DataType> dist(low, high);
+MatType randint(std::size_t nrows,
+    std::size_t ncols,
+    DataType low,
+    DataType high,
+    Philox4x32& generator,
+    std::size_t num_threads = 0) {
 
-    MatType rand_mat = MatType::NullaryExpr(
-        nrows, ncols, [&](){
-            return dist(generator);
+    MatType rand_mat(nrows, ncols);
+    DataType* data = rand_mat.data();
+    std::size_t size = nrows * ncols;
+    double range = static_cast<double>(high) - static_cast<double>(low) + 1.0;
+    generate_blocks(generator, (size + 1) / 2, num_threads,
+        [&](std::size_t i, const Philox4x32::BlockType& block) {
+            std::uint64_t bits[2] = {
+                (static_cast<std::uint64_t>(block[0]) << 32) | block[1],
+                (static_cast<std::uint64_t>(block[2]) << 32) | block[3]
+            };
+            for (std::size_t k = 0; k < 2 && 2 * i + k < size; ++k) {
+                double offset = std::floor(uniform_real<double>(bits[k]) * range);
+                DataType value = static_cast<DataType>(static_cast<double>(low) + offset);
+                data[2 * i + k] = std::min(value, high);
+            }
         }
     );
     return rand_mat;
 };
 
+template<typename DataType,
+    typename MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>>
+MatType randint(std::size_t nrows,
+    std::size_t ncols,
+    DataType low = 0,
+    DataType high = 1e+2) {
+
+    Philox4x32 generator = global_generator();
+    return randint<DataType, MatType>(nrows, ncols, low, high, generator);
+};
+
 
 }
 }
@@ -1,63 +1,72 @@
 #ifndef CORE_MATH_SHUFFLE_HPP
 #define CORE_MATH_SHUFFLE_HPP
 #include "../../prereqs.hpp"
+#include "./random.hpp"
 
 namespace openml {
 namespace random {
 
 /**
  * Shuffle 2d matrices along a specific axis.
- * 
+ *
  * @param X ndarray of shape (num_samples, num_features), input matrix
  * @param shuffled_X output shuffled matrix with the same dims of input matrix
- * @param axis int Axis along which a shuffle is performed, default is 1 
+ * @param axis int Axis along which a shuffle is performed, default is 1,
+ *      0 permutes columns, 1 permutes rows
+ * @param random_state long, seed of the shuffle, default -1 means
+ *      the generator is taken from the global seed
 */
 template<typename MatType>
-void shuffle_data(const MatType& X, 
-    MatType& shuffled_X, 
-    int axis = 1) {
-    
+void shuffle_data(const MatType& X,
+    MatType& shuffled_X,
+    int axis = 1,
+    long random_state = -1) {
+
     std::size_t permut_size;
     if (axis == 0) {
         permut_size = X.cols();
-    } 
-    else if (axis = 1) {
+    }
+    else if (axis == 1) {
         permut_size = X.rows();
     }
+    else {
+        std::ostringstream err_msg;
+        err_msg << "axis must be 0 or 1, but got " << axis << std::endl;
+        throw std::invalid_argument(err_msg.str());
+    }
     // define a index permutation
     Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic> index_permut(permut_size);
     index_permut.setIdentity();
 
-    // generate random seed for shuffle 
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-    std::shuffle(index_permut.indices().data(), 
-        index_permut.indices().data() + index_permut.indices().size(), 
-        std::default_random_engine(seed)
+    Philox4x32 generator = make_generator(random_state);
+    random::shuffle(index_permut.indices().data(),
+        index_permut.indices().data() + index_permut.indices().size(),
+        generator
     );
-    std::cout << index_permut.indices() << std::endl;
     if (axis == 0) {
         // permute columns
         shuffled_X = X * index_permut;
-    } 
-    else if (axis = 1) {
+    }
+    else {
         // permute rows
         shuffled_X = index_permut * X;
-    } 
+    }
 };
 
 template<typename MatType, typename VecType>
 void shuffle_data(const MatType& X,
-    const VecType& y, 
-    MatType& shuffled_X, 
-    VecType& shuffled_y) {
-    
+    const VecType& y,
+    MatType& shuffled_X,
+    VecType& shuffled_y,
+    long random_state = -1) {
+
     std::size_t n_rows = X.rows();
     Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic> index_permut(n_rows);
     index_permut.setIdentity();
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();;
-    std::shuffle(index_permut.indices().data(), 
-        index_permut.indices().data() + index_permut.indices().size(), 
-        std::default_random_engine(seed)
+    Philox4x32 generator = make_generator(random_state);
+    random::shuffle(index_permut.indices().data(),
+        index_permut.indices().data() + index_permut.indices().size(),
+        generator
     );
 
     shuffled_X = index_permut * X;
@@ -0,0 +1,266 @@
+#ifndef CORE_METRIC_PAIRWISE_HPP
+#define CORE_METRIC_PAIRWISE_HPP
+#include "../../prereqs.hpp"
+#include "../parallel/parallel_for.hpp"
+
+namespace openml {
+namespace metric {
+
+/**
+ * size of the distance tiles, a tile of 64 x 512 doubles (256KB)
+ * stays in the L2 cache while it is reduced
+*/
+constexpr std::size_t PAIRWISE_ROW_BLOCK = 64;
+constexpr std::size_t PAIRWISE_COL_BLOCK = 512;
+
+inline void check_pairwise_metric(const std::string& metric) {
+    if (metric != "euclidean" && metric != "sqeuclidean" &&
+        metric != "manhattan" && metric != "cosine") {
+        std::ostringstream err_msg;
+        err_msg << "Metric must be 'euclidean', 'sqeuclidean', 'manhattan' "
+                << "or 'cosine', but got: " << metric << std::endl;
+        throw std::invalid_argument(err_msg.str());
+    }
+};
+
+/**
+ * Compute the distance tile between rows [row_first, row_first + num_rows)
+ * of X and rows [col_first, col_first + num_cols) of Y.
+ *
+ * euclidean distances are expanded as ||x||^2 + ||y||^2 - 2 x.y so that
+ * the tile is a matrix product, cosine distances are 1 - x.y / (||x|| ||y||),
+ * X_norms and Y_norms are the squared row norms.
+*/
+template<typename MatType, typename VecType>
+void pairwise_distances_tile(const MatType& X,
+    const MatType& Y,
+    const VecType& X_norms,
+    const VecType& Y_norms,
+    std::size_t row_first,
+    std::size_t num_rows,
+    std::size_t col_first,
+    std::size_t num_cols,
+    const std::string& metric,
+    MatType& tile) {
+
+    using DataType = typename MatType::Scalar;
+    tile.resize(num_rows, num_cols);
+
+    if (metric == "manhattan") {
+        // transposed copies, so that the features of a sample are contiguous
+        MatType Xt = X.middleRows(row_first, num_rows).transpose();
+        MatType Yt = Y.middleRows(col_first, num_cols).transpose();
+        for (std::size_t j = 0; j < num_cols; ++j) {
+            for (std::size_t i = 0; i < num_rows; ++i) {
+                tile(i, j) = (Xt.col(i) - Yt.col(j)).cwiseAbs().sum();
+            }
+        }
+        return ;
+    }
+
+    tile.noalias() = X.middleRows(row_first, num_rows) *
+        Y.middleRows(col_first, num_cols).transpose();
+
+    if (metric == "cosine") {
+        // a zero vector has a similarity 0 with any vector
+        VecType x_inv = X_norms.segment(row_first, num_rows).cwiseSqrt();
+        VecType y_inv = Y_norms.segment(col_first, num_cols).cwiseSqrt();
+        x_inv = (x_inv.array() > 0).select(x_inv.array().inverse(), 1).matrix();
+        y_inv = (y_inv.array() > 0).select(y_inv.array().inverse(), 1).matrix();
+        tile = x_inv.asDiagonal() * tile * y_inv.asDiagonal();
+        tile = (1 - tile.array()).max(static_cast<DataType>(0))
+            .min(static_cast<DataType>(2)).matrix();
+        return ;
+    }
+
+    tile *= static_cast<DataType>(-2);
+    tile.colwise() += X_norms.segment(row_first, num_rows);
+    tile.rowwise() += Y_norms.segment(col_first, num_cols).transpose();
+    // rounding errors of the expansion may give small negative values
+    tile = tile.cwiseMax(static_cast<DataType>(0));
+    if (metric == "euclidean") {
+        tile = tile.cwiseSqrt();
+    }
+};
+
+/**
+ * Compute distances between X and Y tile by tile and pass each tile to
+ * func(row_first, col_first, tile). Blocks of rows of X are processed in
+ * parallel, a block of rows is only passed to a single thread, so func can
+ * update per row results without synchronization.
+ *
+ * @param X_norms, Y_norms optional squared row norms of X and Y,
+ *      computed if null, they can be cached between calls
+*/
+template<typename MatType, typename VecType, typename Function>
+void pairwise_distances_chunked(const MatType& X,
+    const MatType& Y,
+    const std::string& metric,
+    int n_jobs,
+    const VecType* X_norms,
+    const VecType* Y_norms,
+    Function&& func) {
+
+    check_pairwise_metric(metric);
+    if (X.cols() != Y.cols()) {
+        std::ostringstream err_msg;
+        err_msg << "Incompatible dimension for X and Y matrices: "
+                << "X.cols() = " << X.cols() << " != Y.cols() = "
+                << Y.cols() << std::endl;
+        throw std::invalid_argument(err_msg.str());
+    }
+
+    std::size_t num_rows = X.rows(), num_cols = Y.rows();
+    VecType x_norms, y_norms;
+    if (metric != "manhattan") {
+        x_norms = (X_norms != nullptr) ? *X_norms : VecType(X.rowwise().squaredNorm());
+        y_norms = (Y_norms != nullptr) ? *Y_norms : VecType(Y.rowwise().squaredNorm());
+    }
+
+    parallel::parallel_for(0, num_rows, PAIRWISE_ROW_BLOCK, n_jobs,
+        [&](std::size_t first, std::size_t last) {
+            MatType tile;
+            for (std::size_t row = first; row < last; row += PAIRWISE_ROW_BLOCK) {
+                std::size_t block_rows = std::min(PAIRWISE_ROW_BLOCK, last - row);
+                for (std::size_t col = 0; col < num_cols; col += PAIRWISE_COL_BLOCK) {
+                    std::size_t block_cols = std::min(PAIRWISE_COL_BLOCK, num_cols - col);
+                    pairwise_distances_tile<MatType, VecType>(X, Y, x_norms, y_norms,
+                        row, block_rows, col, block_cols, metric, tile);
+                    func(row, col, tile);
+                }
+            }
+        }
+    );
+};
+
+/**
+ * Compute the distance matrix between the rows of X and the rows of Y.
+ *
+ * @param X ndarray of shape (num_samples_X, num_features)
+ * @param Y ndarray of shape (num_samples_Y, num_features)
+ * @param metric string, "euclidean", "sqeuclidean", "manhattan" or "cosine"
+ * @param n_jobs number of threads, -1 means using all cores
+ * @param X_norms, Y_norms optional cached squared row norms
+ * @return distance matrix of shape (num_samples_X, num_samples_Y)
+*/
+template<typename MatType,
+    typename VecType = Eigen::Matrix<typename MatType::Scalar, Eigen::Dynamic, 1>>
+MatType pairwise_distances(const MatType& X,
+    const MatType& Y,
+    const std::string& metric = "euclidean",
+    int n_jobs = 1,
+    const VecType* X_norms = nullptr,
+    const VecType* Y_norms = nullptr) {
+
+    MatType distances(X.rows(), Y.rows());
+    pairwise_distances_chunked<MatType, VecType>(X, Y, metric, n_jobs, X_norms, Y_norms,
+        [&](std::size_t row, std::size_t col, const MatType& tile) {
+            distances.block(row, col, tile.rows(), tile.cols()) = tile;
+        }
+    );
+    return distances;
+};
+
+/**
+ * Compute for each row of X the closest row of Y, the reduction is fused
+ * with the distance computation, the full distance matrix is never stored.
+ * Ties are resolved by the smallest index.
+ *
+ * @return a tuple of the index of the closest row of Y and its distance
+*/
+template<typename MatType, typename VecType, typename IdxVecType>
+std::tuple<IdxVecType, VecType> pairwise_distances_argmin_min(const MatType& X,
+    const MatType& Y,
+    const std::string& metric = "euclidean",
+    int n_jobs = 1,
+    const VecType* X_norms = nullptr,
+    const VecType* Y_norms = nullptr) {
+
+    using DataType = typename MatType::Scalar;
+    std::size_t num_rows = X.rows();
+    IdxVecType argmin = IdxVecType::Zero(num_rows);
+    VecType min_dist = VecType::Constant(num_rows, ConstType<DataType>::infinity());
+
+    pairwise_distances_chunked<MatType, VecType>(X, Y, metric, n_jobs, X_norms, Y_norms,
+        [&](std::size_t row, std::size_t col, const MatType& tile) {
+            for (std::size_t i = 0; i < static_cast<std::size_t>(tile.rows()); ++i) {
+                Eigen::Index j;
+                DataType dist = tile.row(i).minCoeff(&j);
+                if (dist < min_dist(row + i)) {
+                    min_dist(row + i) = dist;
+                    argmin(row + i) = col + j;
+                }
+            }
+        }
+    );
+    return std::make_tuple(argmin, min_dist);
+};
+
+/**
+ * Compute for each row of X the k closest rows of Y with a bounded heap
+ * per row, fused with the distance computation. Neighbors are sorted by
+ * increasing distance, ties are resolved by the smallest index.
+ *
+ * @return a tuple of distances and indices matrices of shape (num_samples_X, k)
+*/
+template<typename MatType, typename IdxMatType, typename VecType>
+std::tuple<MatType, IdxMatType> pairwise_distances_topk(const MatType& X,
+    const MatType& Y,
+    std::size_t k,
+    const std::string& metric = "euclidean",
+    int n_jobs = 1,
+    const VecType* X_norms = nullptr,
+    const VecType* Y_norms = nullptr) {
+
+    using DataType = typename MatType::Scalar;
+    using NNType = std::pair<DataType, Eigen::Index>;
+
+    if (k == 0 || k > static_cast<std::size_t>(Y.rows())) {
+        std::ostringstream err_msg;
+        err_msg << "Expected 0 < k <= num_samples of Y, but got k = " << k
+                << ", num_samples = " << Y.rows() << std::endl;
+        throw std::invalid_argument(err_msg.str());
+    }
+
+    std::size_t num_rows = X.rows();
+    MatType distances(num_rows, k);
+    IdxMatType indices(num_rows, k);
+    // one heap per row, the largest of the k current neighbors on top
+    std::vector<std::vector<NNType>> heaps(num_rows);
+
+    pairwise_distances_chunked<MatType, VecType>(X, Y, metric, n_jobs, X_norms, Y_norms,
+        [&](std::size_t row, std::size_t col, const MatType& tile) {
+            std::size_t block_rows = tile.rows(), block_cols = tile.cols();
+            for (std::size_t i = 0; i < block_rows; ++i) {
+                std::vector<NNType>& heap = heaps[row + i];
+                heap.reserve(k);
+                for (std::size_t j = 0; j < block_cols; ++j) {
+                    NNType nn(tile(i, j), col + j);
+                    if (heap.size() < k) {
+                        heap.push_back(nn);
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                    else if (nn < heap.front()) {
+                        std::pop_heap(heap.begin(), heap.end());
+                        heap.back() = nn;
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+                // the last tile of the row, write the sorted neighbors
+                if (col + block_cols == static_cast<std::size_t>(Y.rows())) {
+                    std::sort_heap(heap.begin(), heap.end());
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(row + i, j) = heap[j].first;
+                        indices(row + i, j) = heap[j].second;
+                    }
+                    std::vector<NNType>().swap(heap);
+                }
+            }
+        }
+    );
+    return std::make_tuple(distances, indices);
+};
+
+}
+}
+#endif /*CORE_METRIC_PAIRWISE_HPP*/
@@ -33,6 +33,7 @@ protected:
     bool shuffle_;
     bool verbose_;
     bool multi_class_;
+    std::string shuffle_mode_;
 
     MatType x0_;
     MatType opt_x_;
@@ -51,7 +52,8 @@ public:
         const double tol = 0.0001, 
         const bool shuffle = true, 
         const bool verbose = true,
-        const bool multi_class = false): x0_(x0),
+        const bool multi_class = false,
+        const std::string shuffle_mode = "epoch"): x0_(x0),
             loss_func_(loss_func),
             w_update_(w_update),
             lr_decay_(lr_decay),
@@ -61,7 +63,8 @@ public:
             tol_(tol), 
             shuffle_(shuffle),
             verbose_(verbose),
-            multi_class_(multi_class) {};
+            multi_class_(multi_class),
+            shuffle_mode_(shuffle_mode) {};
     
     BaseOptimizer(const MatType& x0,
         const LossFunctionType& loss_func,
@@ -75,7 +78,8 @@ public:
             tol_(tol),
             shuffle_(shuffle),
             verbose_(verbose), 
-            multi_class_(multi_class) {};
+            multi_class_(multi_class),
+            shuffle_mode_("epoch") {};
     
     BaseOptimizer(const MatType& x0,
         const LossFunctionType& loss_func,
@@ -86,13 +90,23 @@ public:
             loss_func_(loss_func),
             max_iter_(max_iter), 
             shuffle_(shuffle),
-            verbose_(verbose) {};
+            verbose_(verbose),
+            shuffle_mode_("epoch") {};
     
     ~BaseOptimizer() {};
 
     virtual void optimize(const MatType& X, 
         const VecType& y) = 0;
 
+    /**
+     * optimize by pulling mini-batches from a data source, the source is 
+     * reset at the beginning of each epoch. Only mini-batch optimizers 
+     * support streaming data source.
+    */
+    virtual void optimize(data::DataSource<DataType>& /*source*/) {
+        throw std::runtime_error("The optimizer does not support streaming data source.");
+    };
+
     const MatType get_coef() const {
         return opt_x_;
     }
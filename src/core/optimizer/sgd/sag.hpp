@@ -30,7 +30,8 @@ public:
         const std::size_t num_iters_no_change = 5,
         const double tol = 0.0001, 
         const bool shuffle = true, 
-        const bool verbose = true): BaseOptimizer<DataType, 
+        const bool verbose = true,
+        const std::string shuffle_mode = "epoch"): BaseOptimizer<DataType, 
             LossFunctionType, 
             UpdatePolicyType, 
             DecayPolicyType>(x0, 
@@ -42,41 +43,54 @@ public:
                 num_iters_no_change, 
                 tol, 
                 shuffle, 
-                verbose) {};
+                verbose, 
+                false, 
+                shuffle_mode) {};
     ~SAG() {};
 
+    /**
+     * optimize on in-memory data, samples are shuffled by permuting 
+     * an index vector, each mini-batch is gathered from X and y 
+     * into a reused buffer, the input data are never copied. Only
+     * full mini-batches are used, the remaining samples are dropped.
+    */
     void optimize(const MatType& X, 
         const VecType& y) {
-        std::size_t num_samples = X.rows(), num_features = X.cols();
-        std::size_t num_batch = num_samples / this->batch_size_;
+        data::InMemoryDataSource<DataType> source(
+            X, y, this->shuffle_, this->shuffle_mode_, this->batch_size_, -1, true
+        );
+        optimize(source);
+    }
+
+    /**
+     * optimize by pulling mini-batches from a data source, the number of 
+     * batches is unknown before the first epoch, so the gradient history 
+     * grows with the batch index.
+    */
+    void optimize(data::DataSource<DataType>& source) {
+        std::size_t num_features = source.num_features();
         std::size_t no_improvement_count = 0;
         
         bool is_converged = false;
         double best_loss = ConstType<double>::infinity();
 
-        MatType X_new = X;
-        VecType y_new = y;
-        // define a matirx to store gradient history and a available of average gradient
-        MatType grad_history(num_features, num_batch);
-        grad_history.setZero();
-        VecType avg_grad = math::mean<MatType>(grad_history, 1);
+        MatType X_batch;
+        VecType y_batch;
+        MatType grad_history(num_features, 0);
+        VecType avg_grad(num_features);
+        avg_grad.setZero();
         VecType grad(num_features);
         
         for (std::size_t iter = 0; iter < this->max_iter_; iter++) {
-            if (this->shuffle_) {
-                random::shuffle_data<MatType, VecType>(X_new, y_new, X_new, y_new);
-            }
-            MatType X_batch(this->batch_size_, num_features);
-            VecType y_batch(this->batch_size_);
-            VecType loss_history(num_batch);
-
+            source.reset();
             double lr = this->lr_decay_.compute(iter);
+            double sum_loss = 0.0;
 
-            for (std::size_t j = 0; j < num_batch; j++) {
-                std::size_t begin = j * this->batch_size_;
-                X_batch = X_new.middleRows(begin, this->batch_size_);
-                y_batch = y_new.middleRows(begin, this->batch_size_);
-
+            for (std::size_t j = 0; source.next_batch(X_batch, y_batch, this->batch_size_) > 0; j++) {
+                if (j >= static_cast<std::size_t>(grad_history.cols())) {
+                    grad_history.conservativeResize(Eigen::NoChange, j + 1);
+                    grad_history.col(j).setZero();
+                }
                 grad = this->loss_func_.gradient(X_batch, y_batch, this->x0_);
                 grad = common::clip<MatType>(grad, this->MAX_DLOSS, this->MIN_DLOSS);
 
@@ -86,11 +100,10 @@ public:
 
                 // W = W - lr * grad; 
                 this->x0_ = this->w_update_.update(this->x0_, avg_grad, lr);
-                double loss = this->loss_func_.evaluate(X_batch, y_batch, this->x0_);
-
-                loss_history(j, 0) = loss;
+                sum_loss += static_cast<double>(
+                    this->loss_func_.evaluate(X_batch, y_batch, this->x0_)
+                );
             }
-            double sum_loss = static_cast<double>(loss_history.array().sum());
 
             if (sum_loss > best_loss - this->tol_ * this->batch_size_) {
                 no_improvement_count +=1;
@@ -47,16 +47,12 @@ public:
         std::size_t feat_index = 0;
         std::size_t num_samples = X.rows(), num_features = X.cols();
 
-        MatType X_new = X;
-        VecType y_new = y;
         VecType grad(num_features);
 
         for (std::size_t iter = 0; iter < this->max_iter_; iter++) {
-            if (this->shuffle_) {
-                random::shuffle_data<MatType, VecType>(X_new, y_new, X_new, y_new);
-            }
-
-            grad = this->loss_func_.gradient(X_new, y_new, this->x0_);
+            // the gradient is computed over all samples, it does not depend 
+            // on the sample order, so the data are neither copied nor shuffled
+            grad = this->loss_func_.gradient(X, y, this->x0_);
 
             double pred_descent = 0.0;
             double best_descent = -1.0;
@@ -94,7 +90,7 @@ public:
             if (this->verbose_) {
                 if ((iter % 100) == 0) {
                     double w_norm = this->x0_.array().abs().sum();
-                    double loss = this->loss_func_.evaluate(X_new, y_new, this->x0_);
+                    double loss = this->loss_func_.evaluate(X, y, this->x0_);
                     std::cout << "-- Epoch = " << iter << ", weight norm = " 
                         << w_norm <<", loss value = " << loss / num_samples << std::endl;
                 }
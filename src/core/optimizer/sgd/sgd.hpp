@@ -31,7 +31,8 @@ public:
         const double tol = 0.0001, 
         const bool shuffle = true, 
         const bool verbose = true,
-        const bool multi_class = false): BaseOptimizer<DataType, 
+        const bool multi_class = false,
+        const std::string shuffle_mode = "epoch"): BaseOptimizer<DataType, 
             LossFunctionType, 
             UpdatePolicyType, 
             DecayPolicyType>(x0, 
@@ -44,56 +45,53 @@ public:
                 tol, 
                 shuffle, 
                 verbose, 
-                multi_class) {};
+                multi_class, 
+                shuffle_mode) {};
     ~SGD() {};
 
+    /**
+     * optimize on in-memory data, samples are shuffled by permuting 
+     * an index vector, each mini-batch is gathered from X and y 
+     * into a reused buffer, the input data are never copied. Only
+     * full mini-batches are used, the remaining samples are dropped.
+    */
     void optimize(const MatType& X, 
         const VecType& y) {
-        
-        std::size_t num_samples = X.rows(), num_features = X.cols();
-        std::size_t num_batch = num_samples / this->batch_size_;
-        std::size_t no_improvement_count = 0;
+        data::InMemoryDataSource<DataType> source(
+            X, y, this->shuffle_, this->shuffle_mode_, this->batch_size_, -1, true
+        );
+        optimize(source);
+    }
 
+    /**
+     * optimize by pulling mini-batches from a data source, samples 
+     * are only resident one batch at a time, the shuffling is done 
+     * by the source, for example with a ShuffleDataSource.
+    */
+    void optimize(data::DataSource<DataType>& source) {
+        std::size_t no_improvement_count = 0;
         bool is_converged = false;
         double best_loss = ConstType<double>::infinity();
-        
-        MatType X_new = X;
-        VecType y_new = y;
+
+        MatType X_batch;
+        VecType y_batch;
         MatType grad;
-        if (this->multi_class_) {
-            std::set<DataType> label_set{y_new.begin(), y_new.end()};
-            std::size_t num_classes = label_set.size();
-            grad.resize(num_features, num_classes);
-        }
-        else {
-            grad.resize(num_features, 1);
-        }
-        
-        for (std::size_t iter = 0; iter < this->max_iter_; iter++) {
-            if (this->shuffle_) {
-                random::shuffle_data<MatType, VecType>(X_new, y_new, X_new, y_new);
-            }
-            MatType X_batch(this->batch_size_, num_features);
-            VecType y_batch(this->batch_size_);
-            VecType loss_history(num_batch);
 
+        for (std::size_t iter = 0; iter < this->max_iter_; iter++) {
+            source.reset();
             double lr = this->lr_decay_.compute(iter);
+            double sum_loss = 0.0;
 
-            for (std::size_t j = 0; j < num_batch; j++) {
-                std::size_t begin = j * this->batch_size_;
-                X_batch = X_new.middleRows(begin, this->batch_size_);
-                y_batch = y_new.middleRows(begin, this->batch_size_);
-
+            while (source.next_batch(X_batch, y_batch, this->batch_size_) > 0) {
                 grad = this->loss_func_.gradient(X_batch, y_batch, this->x0_);
                 // clip gradient with large value 
                 grad = common::clip<MatType>(grad, this->MAX_DLOSS, this->MIN_DLOSS);
                 // W = W - lr * grad; 
                 this->x0_ = this->w_update_.update(this->x0_, grad, lr);
-                double loss = this->loss_func_.evaluate(X_batch, y_batch, this->x0_);
-                loss_history(j, 0) = loss;
+                sum_loss += static_cast<double>(
+                    this->loss_func_.evaluate(X_batch, y_batch, this->x0_)
+                );
             }
-            // compute total loss from one batch
-            double sum_loss = static_cast<double>(loss_history.array().sum());
             
             if (sum_loss > best_loss - this->tol_ * this->batch_size_) {
                 no_improvement_count +=1;
@@ -0,0 +1,122 @@
+#ifndef CORE_PARALLEL_PARALLEL_FOR_HPP
+#define CORE_PARALLEL_PARALLEL_FOR_HPP
+#include "../../prereqs.hpp"
+#include "./thread_pool.hpp"
+
+namespace openml {
+namespace parallel {
+
+/**
+ * default grain size, about 256 chunks whatever the number of threads,
+ * so that chunk boundaries only depend on the range
+*/
+inline std::size_t get_grain_size(std::size_t size, std::size_t grain_size) {
+    if (grain_size == 0) {
+        grain_size = (size + 255) / 256;
+    }
+    return std::max<std::size_t>(grain_size, 1);
+};
+
+/**
+ * Apply func(first, last) on sub-ranges of [begin, end) in parallel.
+ * The range is split in halves until a sub-range has at most grain_size
+ * indices, the right halves are spawned as tasks that idle threads can
+ * steal, so that uneven costs per index are balanced between threads.
+ *
+ * @param begin, end the range of indices
+ * @param grain_size maximum number of indices of a sub-range,
+ *      0 means the range is split into about 256 sub-ranges
+ * @param n_jobs number of threads, 1 runs func(begin, end) in the calling
+ *      thread, -1 means all cores, see get_num_jobs
+ * @param func function called with the bounds of each sub-range
+*/
+template<typename Function>
+void parallel_for(std::size_t begin,
+    std::size_t end,
+    std::size_t grain_size,
+    int n_jobs,
+    Function&& func) {
+
+    if (begin >= end) {
+        return ;
+    }
+    grain_size = get_grain_size(end - begin, grain_size);
+    std::size_t num_jobs = get_num_jobs(n_jobs);
+    if (num_jobs <= 1 || end - begin <= grain_size) {
+        func(begin, end);
+        return ;
+    }
+
+    TaskGroup group(&get_thread_pool(num_jobs));
+    std::function<void(std::size_t, std::size_t)> split;
+    split = [&](std::size_t first, std::size_t last) {
+        while (last - first > grain_size) {
+            std::size_t mid = first + (last - first) / 2;
+            group.run([&split, mid, last]() {
+                split(mid, last);
+            });
+            last = mid;
+        }
+        func(first, last);
+    };
+
+    try {
+        split(begin, end);
+    }
+    catch (...) {
+        // spawned tasks still refer to split, wait for them before leaving
+        try {
+            group.wait();
+        }
+        catch (...) {}
+        throw;
+    }
+    group.wait();
+};
+
+/**
+ * Parallel reduction over [begin, end). The range is cut into chunks of
+ * grain_size indices, func(first, last) computes the partial result of
+ * a chunk, the partial results are combined in order with reduce, so the
+ * result is the same whatever the number of threads.
+ *
+ * @param identity initial value of the reduction
+ * @param func function returning the partial result of a chunk
+ * @param reduce binary function combining two results
+*/
+template<typename ValueType, typename Function, typename Reduction>
+ValueType parallel_reduce(std::size_t begin,
+    std::size_t end,
+    std::size_t grain_size,
+    int n_jobs,
+    const ValueType& identity,
+    Function&& func,
+    Reduction&& reduce) {
+
+    if (begin >= end) {
+        return identity;
+    }
+    grain_size = get_grain_size(end - begin, grain_size);
+    std::size_t num_chunks = (end - begin + grain_size - 1) / grain_size;
+    std::vector<ValueType> partials(num_chunks, identity);
+
+    parallel_for(0, num_chunks, 1, n_jobs,
+        [&](std::size_t first, std::size_t last) {
+            for (std::size_t c = first; c < last; ++c) {
+                std::size_t chunk_begin = begin + c * grain_size;
+                std::size_t chunk_end = std::min(chunk_begin + grain_size, end);
+                partials[c] = func(chunk_begin, chunk_end);
+            }
+        }
+    );
+
+    ValueType result = identity;
+    for (const ValueType& partial : partials) {
+        result = reduce(result, partial);
+    }
+    return result;
+};
+
+}
+}
+#endif /*CORE_PARALLEL_PARALLEL_FOR_HPP*/
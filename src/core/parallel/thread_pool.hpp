@@ -0,0 +1,320 @@
+#ifndef CORE_PARALLEL_THREAD_POOL_HPP
+#define CORE_PARALLEL_THREAD_POOL_HPP
+#include "../../prereqs.hpp"
+
+namespace openml {
+namespace parallel {
+
+/**
+ * Work-stealing thread pool. Each worker owns a task queue, a worker
+ * pushes and pops its own tasks at the back (LIFO, cache friendly), idle
+ * workers steal the oldest tasks at the front of other queues, so uneven
+ * tasks such as tree nodes are balanced between threads. Tasks submitted
+ * by threads outside the pool go into a shared queue.
+ *
+ * The calling thread is counted as one of the threads: a pool of
+ * num_threads threads creates num_threads - 1 workers, the caller
+ * executes tasks while it waits for them, see TaskGroup.
+ *
+ * @param num_threads number of threads, including the calling thread
+*/
+class ThreadPool {
+public:
+    using TaskType = std::function<void()>;
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<TaskType> tasks;
+    };
+
+    struct WorkerInfo {
+        const ThreadPool* pool;
+        std::size_t index;
+    };
+
+    // one queue per worker, the last one is shared by external threads
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> num_queued_;
+    std::atomic<bool> stop_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+
+    static WorkerInfo& current_worker() {
+        static thread_local WorkerInfo info{nullptr, 0};
+        return info;
+    }
+
+    bool pop_back(std::size_t index, TaskType& task) {
+        WorkQueue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool pop_front(std::size_t index, TaskType& task) {
+        WorkQueue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    /**
+     * take a task: first from the own queue of a worker,
+     * then from the shared queue, finally steal from other workers
+    */
+    bool acquire_task(TaskType& task) {
+        if (num_queued_.load() == 0) {
+            return false;
+        }
+        std::size_t num_workers = workers_.size();
+        const WorkerInfo& worker = current_worker();
+        bool is_worker = (worker.pool == this);
+
+        bool found = (is_worker && pop_back(worker.index, task)) ||
+            pop_front(num_workers, task);
+        std::size_t start = is_worker ? worker.index + 1 : 0;
+        for (std::size_t i = 0; !found && i < num_workers; ++i) {
+            std::size_t victim = (start + i) % num_workers;
+            if (!(is_worker && victim == worker.index)) {
+                found = pop_front(victim, task);
+            }
+        }
+        if (found) {
+            num_queued_.fetch_sub(1);
+        }
+        return found;
+    }
+
+    void worker_loop(std::size_t index) {
+        current_worker() = WorkerInfo{this, index};
+        while (true) {
+            if (try_run_task()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.wait(lock, [this]() {
+                return stop_.load() || num_queued_.load() > 0;
+            });
+            if (stop_.load() && num_queued_.load() == 0) {
+                break;
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(std::size_t num_threads): num_queued_(0), stop_(false) {
+        std::size_t num_workers = num_threads > 1 ? num_threads - 1 : 0;
+        for (std::size_t i = 0; i <= num_workers; ++i) {
+            queues_.emplace_back(std::make_unique<WorkQueue>());
+        }
+        workers_.reserve(num_workers);
+        for (std::size_t i = 0; i < num_workers; ++i) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    };
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_.store(true);
+        }
+        sleep_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    };
+
+    /**
+     * push a task into the queue of the current worker, or into the
+     * shared queue when called outside the pool. A task must not throw,
+     * use TaskGroup to propagate exceptions.
+    */
+    void submit(TaskType task) {
+        const WorkerInfo& worker = current_worker();
+        std::size_t index = (worker.pool == this) ? worker.index : workers_.size();
+        // counted before it is pushed, so that the counter never
+        // goes below the number of tasks in the queues
+        num_queued_.fetch_add(1);
+        {
+            WorkQueue& queue = *queues_[index];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.emplace_back(std::move(task));
+        }
+        // lock before notifying, a worker can not miss the
+        // wakeup between its check of the queue and its wait
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        sleep_cv_.notify_one();
+    }
+
+    /**
+     * run one pending task in the calling thread,
+     * return false if there is no task to run
+    */
+    bool try_run_task() {
+        TaskType task;
+        if (!acquire_task(task)) {
+            return false;
+        }
+        task();
+        return true;
+    }
+
+    /**
+     * block the calling thread until done() returns true or a task is
+     * queued. A thread that makes done() true must call notify_waiters.
+    */
+    template<typename Predicate>
+    void wait_for_task(Predicate&& done) {
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [&]() {
+            return done() || num_queued_.load() > 0 || stop_.load();
+        });
+    }
+
+    /**
+     * wake up the threads blocked in wait_for_task and the idle workers,
+     * locking first so that a waiter can not miss the wakeup
+    */
+    void notify_waiters() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        sleep_cv_.notify_all();
+    }
+
+    std::size_t num_threads() const {
+        return workers_.size() + 1;
+    }
+};
+
+/**
+ * A group of tasks executed by a thread pool and waited together,
+ * a null pool runs the tasks immediately in the calling thread.
+ * The first exception thrown by a task is rethrown by wait().
+ *
+ * While waiting, the calling thread executes pending tasks of the pool
+ * instead of blocking, so nested parallel loops, where a task waits
+ * for its own sub-tasks, can not deadlock. It only blocks when there is
+ * no task left to run, until the last task of the group completes.
+*/
+class TaskGroup {
+private:
+    ThreadPool* pool_;
+    std::atomic<std::size_t> num_pending_;
+    std::exception_ptr error_;
+    std::mutex error_mutex_;
+
+    void set_error(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) {
+            error_ = error;
+        }
+    }
+
+    void wait_pending() {
+        while (num_pending_.load() > 0) {
+            // block instead of spinning when there is nothing to steal,
+            // the last task of the group or a new task wakes the thread
+            if (!pool_->try_run_task()) {
+                pool_->wait_for_task([this]() { return num_pending_.load() == 0; });
+            }
+        }
+    }
+
+public:
+    explicit TaskGroup(ThreadPool* pool = nullptr): pool_(pool), num_pending_(0) {};
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        wait_pending();
+    };
+
+    template<typename Function>
+    void run(Function&& func) {
+        if (pool_ == nullptr) {
+            try {
+                func();
+            }
+            catch (...) {
+                set_error(std::current_exception());
+            }
+            return ;
+        }
+        num_pending_.fetch_add(1);
+        pool_->submit([this, pool = pool_, func = std::forward<Function>(func)]() mutable {
+            try {
+                func();
+            }
+            catch (...) {
+                set_error(std::current_exception());
+            }
+            // last access to the group, it may be destroyed right after,
+            // only the pool is used to wake up the waiting thread
+            if (num_pending_.fetch_sub(1) == 1) {
+                pool->notify_waiters();
+            }
+        });
+    }
+
+    void wait() {
+        wait_pending();
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+/**
+ * Number of threads for the given n_jobs, follows the sklearn convention:
+ * a positive value is the number of threads, -1 means all cores,
+ * -2 all cores but one, etc.
+*/
+inline std::size_t get_num_jobs(int n_jobs) {
+    if (n_jobs == 0) {
+        throw std::invalid_argument("n_jobs == 0 has no meaning.");
+    }
+    if (n_jobs > 0) {
+        return static_cast<std::size_t>(n_jobs);
+    }
+    long num_cores = std::max<long>(1, std::thread::hardware_concurrency());
+    return static_cast<std::size_t>(std::max<long>(1, num_cores + 1 + n_jobs));
+};
+
+/**
+ * Shared pool of the given number of threads, pools are created on
+ * first use and live until the end of the program.
+*/
+inline ThreadPool& get_thread_pool(std::size_t num_threads) {
+    static std::mutex mutex;
+    static std::map<std::size_t, std::unique_ptr<ThreadPool>> pools;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<ThreadPool>& pool = pools[num_threads];
+    if (pool == nullptr) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    return *pool;
+};
+
+}
+}
+#endif /*CORE_PARALLEL_THREAD_POOL_HPP*/
@@ -0,0 +1,535 @@
+#ifndef CORE_TREE_BALL_TREE_HPP
+#define CORE_TREE_BALL_TREE_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+
+namespace openml {
+namespace tree {
+
+/**
+ * subtrees of at least this number of points are built in parallel tasks
+*/
+constexpr std::size_t BALLTREE_PARALLEL_BUILD_SIZE = 8192;
+
+/**
+ * number of queries of a block of radius queries
+*/
+constexpr std::size_t BALLTREE_QUERY_BLOCK_SIZE = 64;
+
+/**
+ * Ball tree for nearest neighbors search.
+ *
+ * A node is a ball, the centroid of its points and the largest distance
+ * from the centroid to a point, the triangle inequality gives the lower
+ * bound d(q, centroid) - radius of the distance between a query q and
+ * any point of the node. Unlike boxes of a KD-tree, balls stay tight in
+ * high dimension and only need a metric, not coordinate-wise bounds.
+ * The layout is the same as the KD-tree: flat nodes in preorder and a
+ * single copy of the points reordered in tree order, one per column.
+ *
+ * @param leaf_size number of points at which to switch to brute-force
+ * @param metric string, "euclidean", "manhattan", "chebyshev", "minkowski",
+ *      "cosine" or "haversine".
+ *      "cosine": vectors are normalized, the euclidean distance between
+ *          unit vectors gives the cosine distance 1 - cos = d^2 / 2
+ *      "haversine": great circle distance on the unit sphere, points are
+ *          (latitude, longitude) in radians
+ * @param n_jobs number of threads for the construction and the queries,
+ *      default 1, -1 means using all cores
+ * @param p double, default 2, power of the minkowski metric, p >= 1
+*/
+template<typename DataType>
+class BallTree {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using RowVecType = Eigen::Matrix<DataType, 1, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using NNType = std::pair<DataType, std::size_t>;
+
+    /**
+     * points of a node are the columns [begin, end) of data_,
+     * a leaf has no children, left = right = -1
+    */
+    struct BallTreeNode {
+        std::size_t begin;
+        std::size_t end;
+        long left;
+        long right;
+    };
+
+    // the metric as an enum, strings are not compared per distance
+    enum class MetricType {euclidean, manhattan, chebyshev, minkowski, haversine};
+
+    std::string metric_;
+    std::size_t leaf_size_;
+    int n_jobs_;
+    double p_;
+    MetricType metric_type_;
+    bool cosine_;
+
+    // points in tree order, one point per column
+    MatType data_;
+    // original index of each column of data_
+    IdxVecType indices_;
+    std::vector<BallTreeNode> nodes_;
+    // ball of each node, one centroid per column
+    MatType centroids_;
+    ColVecType radii_;
+
+protected:
+    /**
+     * distance between two points, the cosine metric is
+     * the euclidean distance between normalized points
+    */
+    template<typename Type1, typename Type2>
+    DataType distance(const Eigen::MatrixBase<Type1>& x,
+        const Eigen::MatrixBase<Type2>& y) const {
+
+        if (metric_type_ == MetricType::euclidean) {
+            return (x - y).norm();
+        }
+        else if (metric_type_ == MetricType::manhattan) {
+            return (x - y).cwiseAbs().sum();
+        }
+        else if (metric_type_ == MetricType::chebyshev) {
+            return (x - y).cwiseAbs().maxCoeff();
+        }
+        else if (metric_type_ == MetricType::haversine) {
+            DataType sin_lat = std::sin((x(0) - y(0)) / 2);
+            DataType sin_lon = std::sin((x(1) - y(1)) / 2);
+            DataType a = sin_lat * sin_lat + std::cos(x(0)) * std::cos(y(0)) * sin_lon * sin_lon;
+            return 2 * std::asin(std::sqrt(std::min<DataType>(a, 1)));
+        }
+        return std::pow((x - y).array().abs().pow(p_).sum(), 1.0 / p_);
+    }
+
+    /**
+     * the returned distance from the internal distance
+    */
+    DataType to_distance(DataType dist) const {
+        return cosine_ ? dist * dist / 2 : dist;
+    }
+
+    DataType to_internal_distance(DataType dist) const {
+        return cosine_ ? std::sqrt(2 * std::max<DataType>(dist, 0)) : dist;
+    }
+
+    /**
+     * points as columns, normalized for the cosine metric,
+     * a zero vector stays zero
+    */
+    MatType transform(const MatType& data) const {
+        MatType points = data.transpose();
+        if (cosine_) {
+            for (Eigen::Index i = 0; i < points.cols(); ++i) {
+                DataType norm = points.col(i).norm();
+                if (norm > 0) {
+                    points.col(i) /= norm;
+                }
+            }
+        }
+        return points;
+    }
+
+    /**
+     * lower bound of the distance between a point and the points of a node
+    */
+    DataType min_ball_distance(const ColVecType& point, std::size_t node) const {
+        return std::max<DataType>(distance(point, centroids_.col(node)) - radii_(node), 0);
+    }
+
+    /**
+     * number of nodes of the subtrees of num_samples and num_samples + 1
+     * points, see KDTree::count_nodes
+    */
+    std::pair<std::size_t, std::size_t> count_nodes(std::size_t num_samples) const {
+        std::size_t leaf_size = std::max<std::size_t>(leaf_size_, 1);
+        if (num_samples + 1 <= leaf_size) {
+            return std::make_pair(1, 1);
+        }
+        std::size_t half = num_samples / 2;
+        std::pair<std::size_t, std::size_t> half_count = count_nodes(half);
+        std::size_t count, next_count;
+        if (num_samples % 2 == 0) {
+            count = 1 + 2 * half_count.first;
+            next_count = 1 + half_count.first + half_count.second;
+        }
+        else {
+            count = 1 + half_count.first + half_count.second;
+            next_count = 1 + 2 * half_count.second;
+        }
+        if (num_samples <= leaf_size) {
+            count = 1;
+        }
+        return std::make_pair(count, next_count);
+    }
+
+    /**
+     * build the subtree of root index over the points order[begin, end),
+     * points are split at the median of the dimension of largest spread,
+     * the ball of a node is the mean of its points and the largest
+     * distance to the mean
+    */
+    void build_node(const MatType& points,
+        std::vector<Eigen::Index>& order,
+        std::size_t index,
+        std::size_t begin,
+        std::size_t end,
+        parallel::ThreadPool* pool) {
+
+        std::size_t num_features = points.rows();
+        ColVecType lower = ColVecType::Constant(num_features, ConstType<DataType>::infinity());
+        ColVecType upper = ColVecType::Constant(num_features, -ConstType<DataType>::infinity());
+        ColVecType centroid = ColVecType::Zero(num_features);
+        for (std::size_t i = begin; i < end; ++i) {
+            lower = lower.cwiseMin(points.col(order[i]));
+            upper = upper.cwiseMax(points.col(order[i]));
+            centroid += points.col(order[i]);
+        }
+        centroid /= static_cast<DataType>(end - begin);
+        DataType radius = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            radius = std::max(radius, distance(points.col(order[i]), centroid));
+        }
+        centroids_.col(index) = centroid;
+        radii_(index) = radius;
+        nodes_[index] = BallTreeNode{begin, end, -1, -1};
+
+        if (end - begin <= std::max<std::size_t>(leaf_size_, 1)) {
+            return ;
+        }
+
+        Eigen::Index split_dim;
+        (upper - lower).maxCoeff(&split_dim);
+        std::size_t mid = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+            [&points, split_dim](Eigen::Index i, Eigen::Index j) {
+                return points(split_dim, i) < points(split_dim, j);
+            }
+        );
+        std::size_t left = index + 1;
+        std::size_t right = left + count_nodes(mid - begin).first;
+        nodes_[index].left = left;
+        nodes_[index].right = right;
+
+        bool spawn = (end - begin >= BALLTREE_PARALLEL_BUILD_SIZE);
+        parallel::TaskGroup group(spawn ? pool : nullptr);
+        group.run([&, left, begin, mid]() {
+            build_node(points, order, left, begin, mid, pool);
+        });
+        build_node(points, order, right, mid, end, pool);
+        group.wait();
+    }
+
+    void build_tree(const MatType& data) {
+        std::size_t num_samples = data.rows(), num_features = data.cols();
+        if (num_samples == 0) {
+            throw std::invalid_argument("Cannot build a BallTree without data.");
+        }
+        if (metric_type_ == MetricType::haversine && num_features != 2) {
+            throw std::invalid_argument("Haversine metric needs (latitude, longitude) data.");
+        }
+        MatType points = transform(data);
+        std::vector<Eigen::Index> order(num_samples);
+        std::iota(order.begin(), order.end(), 0);
+
+        std::size_t num_nodes = count_nodes(num_samples).first;
+        nodes_.resize(num_nodes);
+        centroids_.resize(num_features, num_nodes);
+        radii_.resize(num_nodes);
+
+        std::size_t num_jobs = parallel::get_num_jobs(n_jobs_);
+        parallel::ThreadPool* pool = (num_jobs > 1) ? &parallel::get_thread_pool(num_jobs) : nullptr;
+        build_node(points, order, 0, 0, num_samples, pool);
+
+        indices_ = Eigen::Map<IdxVecType>(order.data(), num_samples);
+        data_ = points(Eigen::all, order);
+    }
+
+    /**
+     * k nearest neighbors of a single point, on return heap holds the
+     * neighbors sorted by increasing internal distance. The stack holds
+     * nodes with their lower bound, the closer child is visited first.
+    */
+    void query_single_data(const ColVecType& point,
+        std::size_t k,
+        std::vector<NNType>& heap,
+        std::vector<std::pair<DataType, std::size_t>>& node_stack) const {
+
+        heap.clear();
+        node_stack.clear();
+        node_stack.emplace_back(min_ball_distance(point, 0), 0);
+        while (!node_stack.empty()) {
+            DataType bound = node_stack.back().first;
+            std::size_t node = node_stack.back().second;
+            node_stack.pop_back();
+            if (heap.size() == k && bound > heap.front().first) {
+                continue;
+            }
+
+            const BallTreeNode& info = nodes_[node];
+            if (info.left < 0) {
+                for (std::size_t i = info.begin; i < info.end; ++i) {
+                    NNType nn(distance(data_.col(i), point), indices_(i));
+                    if (heap.size() < k) {
+                        heap.push_back(nn);
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                    else if (nn < heap.front()) {
+                        std::pop_heap(heap.begin(), heap.end());
+                        heap.back() = nn;
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+                continue;
+            }
+            DataType left_bound = min_ball_distance(point, info.left);
+            DataType right_bound = min_ball_distance(point, info.right);
+            if (left_bound <= right_bound) {
+                node_stack.emplace_back(right_bound, info.right);
+                node_stack.emplace_back(left_bound, info.left);
+            }
+            else {
+                node_stack.emplace_back(left_bound, info.left);
+                node_stack.emplace_back(right_bound, info.right);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end());
+    }
+
+    /**
+     * neighbors of a single point within the internal radius,
+     * a node entirely inside the radius is taken without test
+    */
+    template<typename Function>
+    void query_radius_single_data(const ColVecType& point,
+        DataType radius,
+        std::vector<std::size_t>& node_stack,
+        Function&& func) const {
+
+        node_stack.clear();
+        node_stack.push_back(0);
+        while (!node_stack.empty()) {
+            std::size_t node = node_stack.back();
+            node_stack.pop_back();
+            DataType center_dist = distance(point, centroids_.col(node));
+            if (center_dist - radii_(node) > radius) {
+                continue;
+            }
+
+            const BallTreeNode& info = nodes_[node];
+            bool inside = (center_dist + radii_(node) <= radius);
+            if (info.left < 0 || inside) {
+                for (std::size_t i = info.begin; i < info.end; ++i) {
+                    func(i, inside);
+                }
+                continue;
+            }
+            node_stack.push_back(info.right);
+            node_stack.push_back(info.left);
+        }
+    }
+
+public:
+    BallTree(const MatType& data,
+        std::size_t leaf_size,
+        std::string metric,
+        int n_jobs = 1,
+        double p = 2): metric_(metric),
+            leaf_size_(leaf_size),
+            n_jobs_(n_jobs),
+            p_(p),
+            cosine_(metric == "cosine") {
+        if (metric == "euclidean" || metric == "cosine") {
+            metric_type_ = MetricType::euclidean;
+        }
+        else if (metric == "manhattan") {
+            metric_type_ = MetricType::manhattan;
+        }
+        else if (metric == "chebyshev") {
+            metric_type_ = MetricType::chebyshev;
+        }
+        else if (metric == "minkowski") {
+            metric_type_ = MetricType::minkowski;
+        }
+        else if (metric == "haversine") {
+            metric_type_ = MetricType::haversine;
+        }
+        else {
+            std::ostringstream err_msg;
+            err_msg << "Metric must be 'euclidean', 'manhattan', 'chebyshev', "
+                    << "'minkowski', 'cosine' or 'haversine', but got: "
+                    << metric << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (metric == "minkowski" && p < 1) {
+            std::ostringstream err_msg;
+            err_msg << "Minkowski metric needs p >= 1, but got p = " << p << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        build_tree(data);
+    };
+
+    BallTree(const MatType& data): metric_("euclidean"),
+        leaf_size_(10),
+        n_jobs_(1),
+        p_(2),
+        metric_type_(MetricType::euclidean),
+        cosine_(false) {
+            build_tree(data);
+        };
+
+    ~BallTree() {};
+
+    /**
+     * k nearest neighbors of a batch of points, written into the
+     * preallocated output matrices, see KDTree::query
+    */
+    void query(const MatType& data,
+        std::size_t k,
+        MatType& distances,
+        IdxMatType& indices) const {
+
+        std::size_t num_samples = data.rows();
+        if (k == 0 || k > static_cast<std::size_t>(data_.cols())) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_samples of the tree, but got k = "
+                    << k << ", num_samples = " << data_.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        resize_query_outputs(num_samples, k, distances, indices);
+
+        MatType points = transform(data);
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(points.rows());
+                std::vector<NNType> heap;
+                std::vector<std::pair<DataType, std::size_t>> node_stack;
+                heap.reserve(k);
+                for (std::size_t i = first; i < last; ++i) {
+                    point = points.col(i);
+                    query_single_data(point, k, heap, node_stack);
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(i, j) = to_distance(heap[j].first);
+                        indices(i, j) = heap[j].second;
+                    }
+                }
+            }
+        );
+    }
+
+    const std::pair<MatType, IdxMatType> query(
+        const MatType& data,
+        std::size_t k) const {
+
+        MatType distances;
+        IdxMatType indices;
+        query(data, k, distances, indices);
+        return std::make_pair(distances, indices);
+    }
+
+    /**
+     * neighbors within a radius of a batch of points in CSR format,
+     * see KDTree::query_radius
+     * @return a tuple of offsets of size num_samples + 1, indices and distances
+    */
+    const std::tuple<IdxVecType, IdxVecType, ColVecType> query_radius(
+        const MatType& data,
+        double radius,
+        bool sort_results = true) const {
+
+        DataType internal_radius = to_internal_distance(static_cast<DataType>(radius));
+        MatType points = transform(data);
+        return query_radius_csr<IdxVecType, ColVecType, NNType>(
+            data.rows(), BALLTREE_QUERY_BLOCK_SIZE, n_jobs_, sort_results,
+            [&]() {
+                return [&, point = ColVecType(points.rows()), node_stack = std::vector<std::size_t>()]
+                    (std::size_t i, std::vector<NNType>& nns) mutable {
+                    point = points.col(i);
+                    query_radius_single_data(point, internal_radius, node_stack,
+                        [&](std::size_t j, bool inside) {
+                            DataType dist = distance(data_.col(j), point);
+                            if (inside || dist <= internal_radius) {
+                                nns.emplace_back(to_distance(dist), indices_(j));
+                            }
+                        }
+                    );
+                };
+            }
+        );
+    }
+
+    /**
+     * number of neighbors within a radius of each point
+     * @return counts of shape (num_samples,)
+    */
+    const IdxVecType query_radius_count(
+        const MatType& data,
+        double radius) const {
+
+        std::size_t num_samples = data.rows();
+        DataType internal_radius = to_internal_distance(static_cast<DataType>(radius));
+        IdxVecType counts(num_samples);
+        MatType points = transform(data);
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(points.rows());
+                std::vector<std::size_t> node_stack;
+                for (std::size_t i = first; i < last; ++i) {
+                    point = points.col(i);
+                    std::size_t count = 0;
+                    query_radius_single_data(point, internal_radius, node_stack,
+                        [&](std::size_t j, bool inside) {
+                            if (inside || distance(data_.col(j), point) <= internal_radius) {
+                                ++count;
+                            }
+                        }
+                    );
+                    counts(i) = count;
+                }
+            }
+        );
+        return counts;
+    }
+
+    /**
+     * read-only view of the nodes, see KDTree::get_node, points of 
+     * get_data() are normalized for the cosine metric
+    */
+    std::tuple<std::size_t, std::size_t, long, long> get_node(std::size_t node) const {
+        const BallTreeNode& info = nodes_[node];
+        return std::make_tuple(info.begin, info.end, info.left, info.right);
+    }
+
+    std::size_t get_num_nodes() const {
+        return nodes_.size();
+    }
+
+    const MatType& get_data() const {
+        return data_;
+    }
+
+    const IdxVecType& get_indices() const {
+        return indices_;
+    }
+
+    /**
+     * lower and upper bounds of the distance between a point and the
+     * points of a node, from the ball of the node, in the internal
+     * distance of the tree for the cosine metric
+    */
+    std::pair<DataType, DataType> get_node_distance_bounds(
+        const ColVecType& point, 
+        std::size_t node) const {
+        
+        DataType dist = distance(point, centroids_.col(node));
+        return std::make_pair(std::max<DataType>(dist - radii_(node), 0), dist + radii_(node));
+    }
+
+};
+
+}
+}
+#endif /*CORE_TREE_BALL_TREE_HPP*/
@@ -0,0 +1,501 @@
+#ifndef CORE_TREE_DYNAMIC_KD_TREE_HPP
+#define CORE_TREE_DYNAMIC_KD_TREE_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+
+namespace openml {
+namespace tree {
+
+template<typename DataType>
+class KDTree;
+
+/**
+ * KD-tree supporting insertions and deletions, by the logarithmic method
+ * of Bentley and Saxe 1980 "Decomposable searching problems I: static-
+ * to-dynamic transformation".
+ *
+ * New points go to a small buffer searched by brute force. A full buffer
+ * is merged with the static KDTrees of the lowest levels into a single
+ * tree, the level l holds at most buffer_size * 2^l points, so a point is
+ * rebuilt O(log n) times. Removed points are marked in a tombstone array
+ * and skipped by the searches, they are dropped when their tree is merged.
+ * Once tombstones exceed compact_ratio of the stored points, all trees are
+ * rebuilt into one by a background thread, the old trees are searched
+ * until the new one is swapped in.
+ *
+ * Queries hold a shared lock and run concurrently, insertions and removals
+ * are serialized and only take the exclusive lock to publish their changes,
+ * trees are built outside of it. Results are exact: every live point is in
+ * exactly one tree or in the buffer.
+ *
+ * @param leaf_size number of points at which to switch to brute-force
+ * @param metric string, "manhattan", "euclidean" or "chebyshev"
+ * @param buffer_size size_t, default 1024, number of points inserted
+ *      before the buffer is merged into a tree
+ * @param compact_ratio double, default 0.25, fraction of removed points
+ *      of the trees above which they are compacted
+ * @param n_jobs number of threads for the construction and the queries,
+ *      default 1, -1 means using all cores
+*/
+template<typename DataType>
+class DynamicKDTree {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using NNType = std::pair<DataType, std::size_t>;
+
+    /**
+     * static tree of a level, ids(i) is the id of the row i of its data
+    */
+    struct Bucket {
+        IdxVecType ids;
+        KDTree<DataType> tree;
+
+        Bucket(const MatType& data,
+            const IdxVecType& ids_,
+            std::size_t leaf_size,
+            const std::string& metric,
+            int n_jobs): ids(ids_),
+                tree(data, leaf_size, metric, n_jobs) {};
+    };
+    using BucketPtr = std::shared_ptr<const Bucket>;
+
+    int ord_;
+    std::string metric_;
+    std::size_t leaf_size_;
+    std::size_t buffer_size_;
+    double compact_ratio_;
+    int n_jobs_;
+
+    std::size_t num_features_;
+    // recent points, one point per row, the first buffer_count_ rows are used
+    MatType buffer_;
+    IdxVecType buffer_ids_;
+    std::size_t buffer_count_;
+    // levels_[l] holds at most buffer_size * 2^l points or is empty
+    std::vector<BucketPtr> levels_;
+    // result of the last compaction and trees being compacted
+    BucketPtr base_;
+    std::vector<BucketPtr> compacting_;
+    // tombstones, alive_[id] is 0 once the point id is removed
+    std::vector<std::uint8_t> alive_;
+    // points held by the buffer and the trees, and removed ones among them
+    std::size_t num_stored_;
+    std::size_t num_removed_;
+
+    // queries hold mutex_ shared, writers hold write_mutex_ and publish
+    // their changes under mutex_
+    mutable std::shared_mutex mutex_;
+    std::mutex write_mutex_;
+    std::condition_variable compact_cv_;
+    std::thread compact_thread_;
+
+protected:
+    /**
+     * reduced distance, as computed by the KDTree
+    */
+    template<typename DiffType>
+    DataType reduce_distance(const Eigen::MatrixBase<DiffType>& diff) const {
+        if (ord_ == 2) {
+            return diff.squaredNorm();
+        }
+        else if (ord_ == 1) {
+            return diff.cwiseAbs().sum();
+        }
+        return diff.cwiseAbs().maxCoeff();
+    }
+
+    DataType to_distance(DataType rdist) const {
+        return (ord_ == 2) ? std::sqrt(rdist) : rdist;
+    }
+
+    /**
+     * copy the live points of a bucket at the end of data and ids,
+     * return the number of removed points skipped
+    */
+    std::size_t gather_bucket(const Bucket& bucket,
+        MatType& data,
+        IdxVecType& ids,
+        std::size_t& count) const {
+
+        const KDTree<DataType>& tree = bucket.tree;
+        std::size_t num_dropped = 0;
+        for (Eigen::Index i = 0; i < tree.data_.cols(); ++i) {
+            Eigen::Index id = bucket.ids(tree.indices_(i));
+            if (!alive_[id]) {
+                ++num_dropped;
+                continue;
+            }
+            data.row(count) = tree.data_.col(i).transpose();
+            ids(count++) = id;
+        }
+        return num_dropped;
+    }
+
+    /**
+     * build a bucket from the first count rows, nullptr if there are none
+    */
+    BucketPtr make_bucket(const MatType& data, const IdxVecType& ids, std::size_t count) const {
+        if (count == 0) {
+            return nullptr;
+        }
+        return std::make_shared<const Bucket>(
+            data.topRows(count), ids.head(count), leaf_size_, metric_, n_jobs_
+        );
+    }
+
+    /**
+     * merge the buffer, the new points and the trees of the lowest levels
+     * into the first level which is empty and large enough, the caller
+     * holds write_mutex_
+    */
+    void flush(const MatType& data, const IdxVecType& ids) {
+        std::size_t total = buffer_count_ + data.rows(), level = 0;
+        std::vector<std::size_t> merged;
+        while ((level < levels_.size() && levels_[level]) || (buffer_size_ << level) < total) {
+            if (level < levels_.size() && levels_[level]) {
+                total += levels_[level]->ids.size();
+                merged.push_back(level);
+            }
+            ++level;
+        }
+
+        MatType points(total, num_features_);
+        IdxVecType point_ids(total);
+        std::size_t count = 0, num_dropped = 0;
+        for (std::size_t i = 0; i < buffer_count_; ++i) {
+            if (!alive_[buffer_ids_(i)]) {
+                ++num_dropped;
+                continue;
+            }
+            points.row(count) = buffer_.row(i);
+            point_ids(count++) = buffer_ids_(i);
+        }
+        points.middleRows(count, data.rows()) = data;
+        point_ids.segment(count, data.rows()) = ids;
+        count += data.rows();
+        for (std::size_t l : merged) {
+            num_dropped += gather_bucket(*levels_[l], points, point_ids, count);
+        }
+        BucketPtr bucket = make_bucket(points, point_ids, count);
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (levels_.size() <= level) {
+            levels_.resize(level + 1);
+        }
+        levels_[level] = bucket;
+        for (std::size_t l : merged) {
+            levels_[l].reset();
+        }
+        buffer_count_ = 0;
+        num_stored_ += data.rows();
+        num_stored_ -= num_dropped;
+        num_removed_ -= num_dropped;
+    }
+
+    /**
+     * move all trees to compacting_ and rebuild them into a single tree
+     * in a background thread, the caller holds write_mutex_
+    */
+    void start_compaction() {
+        if (!compacting_.empty()) {
+            return ;
+        }
+        if (compact_thread_.joinable()) {
+            compact_thread_.join();
+        }
+        std::vector<BucketPtr> buckets;
+        if (base_) {
+            buckets.push_back(base_);
+        }
+        for (const BucketPtr& bucket : levels_) {
+            if (bucket) {
+                buckets.push_back(bucket);
+            }
+        }
+        if (buckets.empty()) {
+            return ;
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            compacting_ = buckets;
+            base_.reset();
+            for (BucketPtr& bucket : levels_) {
+                bucket.reset();
+            }
+        }
+        compact_thread_ = std::thread(&DynamicKDTree::run_compaction, this);
+    }
+
+    /**
+     * body of the compaction thread, points removed while the tree is
+     * built stay as tombstones of the new tree
+    */
+    void run_compaction() {
+        MatType points;
+        IdxVecType point_ids;
+        std::size_t count = 0, num_dropped = 0;
+        {
+            std::lock_guard<std::mutex> write_lock(write_mutex_);
+            std::size_t total = 0;
+            for (const BucketPtr& bucket : compacting_) {
+                total += bucket->ids.size();
+            }
+            points.resize(total, num_features_);
+            point_ids.resize(total);
+            for (const BucketPtr& bucket : compacting_) {
+                num_dropped += gather_bucket(*bucket, points, point_ids, count);
+            }
+        }
+        BucketPtr bucket = make_bucket(points, point_ids, count);
+
+        {
+            std::lock_guard<std::mutex> write_lock(write_mutex_);
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            base_ = bucket;
+            compacting_.clear();
+            num_stored_ -= num_dropped;
+            num_removed_ -= num_dropped;
+        }
+        compact_cv_.notify_all();
+    }
+
+public:
+    DynamicKDTree(): ord_(2),
+        metric_("euclidean"),
+        leaf_size_(10),
+        buffer_size_(1024),
+        compact_ratio_(0.25),
+        n_jobs_(1),
+        num_features_(0),
+        buffer_count_(0),
+        num_stored_(0),
+        num_removed_(0) {};
+
+    DynamicKDTree(std::size_t leaf_size,
+        std::string metric,
+        std::size_t buffer_size = 1024,
+        double compact_ratio = 0.25,
+        int n_jobs = 1): metric_(metric),
+            leaf_size_(leaf_size),
+            buffer_size_(buffer_size),
+            compact_ratio_(compact_ratio),
+            n_jobs_(n_jobs),
+            num_features_(0),
+            buffer_count_(0),
+            num_stored_(0),
+            num_removed_(0) {
+        if (metric == "manhattan") {
+            ord_ = 1;
+        }
+        else if (metric == "euclidean") {
+            ord_ = 2;
+        }
+        else if (metric == "chebyshev") {
+            ord_ = Eigen::Infinity;
+        }
+        else {
+            std::ostringstream err_msg;
+            err_msg << "Metric must be 'manhattan', 'euclidean' or 'chebyshev', "
+                    << "but got: " << metric << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (buffer_size == 0) {
+            throw std::invalid_argument("buffer_size must be positive.");
+        }
+    };
+
+    ~DynamicKDTree() {
+        if (compact_thread_.joinable()) {
+            compact_thread_.join();
+        }
+    };
+
+    /**
+     * insert the rows of data, they are appended to the buffer, or merged
+     * with it and the lowest levels into a new tree if it overflows
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @return ids of the new points, they follow the ids of the points
+     *      inserted before, removed points included
+    */
+    const IdxVecType insert(const MatType& data) {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        std::size_t num_samples = data.rows();
+        if (num_features_ > 0 && static_cast<std::size_t>(data.cols()) != num_features_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected " << num_features_ << " features, but got "
+                    << data.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        IdxVecType ids = IdxVecType::LinSpaced(num_samples, alive_.size(), alive_.size() + num_samples - 1);
+        if (num_samples == 0) {
+            return ids;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (num_features_ == 0) {
+            num_features_ = data.cols();
+            buffer_.resize(buffer_size_, num_features_);
+            buffer_ids_.resize(buffer_size_);
+        }
+        alive_.resize(alive_.size() + num_samples, 1);
+        if (buffer_count_ + num_samples <= buffer_size_) {
+            buffer_.middleRows(buffer_count_, num_samples) = data;
+            buffer_ids_.segment(buffer_count_, num_samples) = ids;
+            buffer_count_ += num_samples;
+            num_stored_ += num_samples;
+            return ids;
+        }
+        lock.unlock();
+        flush(data, ids);
+        return ids;
+    }
+
+    /**
+     * remove points by id, they are skipped by queries at once and
+     * dropped from the trees when these are merged or compacted
+     * @param ids ids returned by insert
+    */
+    void remove(const IdxVecType& ids) {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        for (Eigen::Index i = 0; i < ids.size(); ++i) {
+            if (ids(i) < 0 || static_cast<std::size_t>(ids(i)) >= alive_.size() || !alive_[ids(i)]) {
+                std::ostringstream err_msg;
+                err_msg << "Point " << ids(i) << " is not in the tree." << std::endl;
+                throw std::invalid_argument(err_msg.str());
+            }
+        }
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            for (Eigen::Index i = 0; i < ids.size(); ++i) {
+                if (alive_[ids(i)]) {
+                    alive_[ids(i)] = 0;
+                    ++num_removed_;
+                }
+            }
+        }
+        if (num_removed_ > compact_ratio_ * num_stored_) {
+            start_compaction();
+        }
+    }
+
+    /**
+     * rebuild all trees into one without removed points in the background,
+     * queries keep using the old trees until it is done
+     * @param wait bool, default false, block until the compaction is done
+    */
+    void compact(bool wait = false) {
+        std::unique_lock<std::mutex> write_lock(write_mutex_);
+        start_compaction();
+        if (wait) {
+            compact_cv_.wait(write_lock, [this]() { return compacting_.empty(); });
+        }
+    }
+
+    /**
+     * exact k nearest neighbors of a batch of points among the live
+     * points, queries are split between threads and written into the
+     * output matrices, the buffer and every tree are searched with a
+     * shared heap, so trees are pruned by the neighbors already found
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param distances output distances sorted by increasing distance
+     * @param indices output ids of the neighbors
+    */
+    void query(const MatType& data,
+        std::size_t k,
+        MatType& distances,
+        IdxMatType& indices) const {
+
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::size_t num_samples = data.rows();
+        std::size_t num_points = num_stored_ - num_removed_;
+        if (k == 0 || k > num_points) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_points of the tree, but got k = "
+                    << k << ", num_points = " << num_points << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (static_cast<std::size_t>(data.cols()) != num_features_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected " << num_features_ << " features, but got "
+                    << data.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        resize_query_outputs(num_samples, k, distances, indices);
+
+        // largest trees first, they give the tightest bound
+        std::vector<const Bucket*> buckets;
+        if (base_) {
+            buckets.push_back(base_.get());
+        }
+        for (const BucketPtr& bucket : compacting_) {
+            buckets.push_back(bucket.get());
+        }
+        for (std::size_t l = levels_.size(); l-- > 0; ) {
+            if (levels_[l]) {
+                buckets.push_back(levels_[l].get());
+            }
+        }
+
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(data.cols());
+                std::vector<NNType> heap;
+                std::vector<std::size_t> node_stack;
+                heap.reserve(k);
+                for (std::size_t i = first; i < last; ++i) {
+                    point = data.row(i).transpose();
+                    heap.clear();
+                    for (std::size_t j = 0; j < buffer_count_; ++j) {
+                        if (!alive_[buffer_ids_(j)]) {
+                            continue;
+                        }
+                        KDTree<DataType>::push_neighbor(heap, k, 
+                            NNType(reduce_distance(buffer_.row(j).transpose() - point), buffer_ids_(j)));
+                    }
+                    for (const Bucket* bucket : buckets) {
+                        const IdxVecType& ids = bucket->ids;
+                        bucket->tree.search_single_data(point, k,
+                            [&](Eigen::Index index) {
+                                Eigen::Index id = ids(index);
+                                return alive_[id] ? static_cast<long>(id) : -1L;
+                            },
+                            heap, node_stack);
+                    }
+                    std::sort_heap(heap.begin(), heap.end());
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(i, j) = to_distance(heap[j].first);
+                        indices(i, j) = heap[j].second;
+                    }
+                }
+            }
+        );
+    }
+
+    const std::pair<MatType, IdxMatType> query(
+        const MatType& data,
+        std::size_t k) const {
+
+        MatType distances;
+        IdxMatType indices;
+        query(data, k, distances, indices);
+        return std::make_pair(distances, indices);
+    }
+
+    /**
+     * number of live points
+    */
+    std::size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return num_stored_ - num_removed_;
+    }
+
+};
+
+}
+}
+#endif /*CORE_TREE_DYNAMIC_KD_TREE_HPP*/
@@ -0,0 +1,663 @@
+#ifndef CORE_TREE_HNSW_HPP
+#define CORE_TREE_HNSW_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+
+namespace openml {
+namespace tree {
+
+/**
+ * On-disk layout of a HNSW index file
+ *
+ *      [HNSWHeader][data][levels][layer 0 links][upper layer links]
+*/
+struct HNSWHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint8_t dtype;
+    std::uint8_t metric;
+    std::uint8_t reserved[2];
+    std::uint64_t M;
+    std::uint64_t ef_construction;
+    std::uint64_t num_points;
+    std::uint64_t num_features;
+    std::int64_t max_level;
+    std::int64_t entry_point;
+};
+
+constexpr char HNSW_MAGIC[8] = {'O', 'P', 'E', 'N', 'M', 'L', 'H', 'N'};
+constexpr std::uint32_t HNSW_VERSION = 1;
+
+/**
+ * Hierarchical navigable small world graph, Malkov and Yashunin 2018
+ * "Efficient and robust approximate nearest neighbor search using
+ * hierarchical navigable small world graphs".
+ *
+ * Each point is inserted at a random level, drawn from an exponential
+ * distribution, and linked to its closest points in every layer up to
+ * its level. A search descends greedily from the entry point through
+ * the upper layers, then runs a best-first search of width ef in layer 0.
+ * Points are inserted concurrently, each point has a lock protecting its
+ * neighbor lists, the entry point has its own lock.
+ *
+ * Layer 0 links are stored in a flat array of num_points x (2M + 1) ids,
+ * the first id of a list is the number of neighbors.
+ *
+ * @param M size_t, default 16, number of neighbors of a point in the
+ *      upper layers, 2M in layer 0
+ * @param ef_construction size_t, default 200, size of the candidate list
+ *      during insertion, larger values give a better graph
+ * @param ef_search size_t, default 50, size of the candidate list during
+ *      queries, the recall/latency trade off, at least k is used
+ * @param metric string, "euclidean" or "cosine"
+ * @param random_state long, default -1, seed of the levels
+ * @param n_jobs number of threads for insertion and queries,
+ *      default 1, -1 means using all cores
+*/
+template<typename DataType>
+class HNSW {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using IdType = std::uint32_t;
+    using NNType = std::pair<DataType, IdType>;
+    using MaxHeapType = std::priority_queue<NNType>;
+    using MinHeapType = std::priority_queue<NNType, std::vector<NNType>, std::greater<NNType>>;
+
+    std::size_t M_;
+    std::size_t max_M0_;
+    std::size_t ef_construction_;
+    std::size_t ef_search_;
+    std::string metric_;
+    bool cosine_;
+    long random_state_;
+    int n_jobs_;
+    double level_mult_;
+
+    // points as columns, normalized for the cosine metric
+    MatType data_;
+    std::size_t num_points_;
+    std::vector<int> levels_;
+    std::vector<IdType> links0_;
+    std::vector<std::vector<IdType>> upper_links_;
+    std::deque<std::mutex> link_mutexes_;
+    std::mutex entry_mutex_;
+    long entry_point_;
+    int max_level_;
+    random::Philox4x32 generator_;
+
+protected:
+    /**
+     * squared euclidean distance, or 1 - cos between normalized points
+    */
+    DataType distance(const DataType* x, const DataType* y) const {
+        Eigen::Map<const ColVecType> a(x, data_.rows()), b(y, data_.rows());
+        if (cosine_) {
+            return 1 - a.dot(b);
+        }
+        return (a - b).squaredNorm();
+    }
+
+    DataType to_distance(DataType dist) const {
+        return cosine_ ? dist : std::sqrt(std::max<DataType>(dist, 0));
+    }
+
+    MatType transform(const MatType& data) const {
+        MatType points = data.transpose();
+        if (cosine_) {
+            for (Eigen::Index i = 0; i < points.cols(); ++i) {
+                DataType norm = points.col(i).norm();
+                if (norm > 0) {
+                    points.col(i) /= norm;
+                }
+            }
+        }
+        return points;
+    }
+
+    /**
+     * neighbor list of a point in a layer, the first element is the count
+    */
+    IdType* get_links(IdType id, int level) {
+        if (level == 0) {
+            return &links0_[id * (max_M0_ + 1)];
+        }
+        return &upper_links_[id][(level - 1) * (M_ + 1)];
+    }
+
+    const IdType* get_links(IdType id, int level) const {
+        if (level == 0) {
+            return &links0_[id * (max_M0_ + 1)];
+        }
+        return &upper_links_[id][(level - 1) * (M_ + 1)];
+    }
+
+    /**
+     * copy the neighbors of a point, under its lock during construction
+    */
+    void copy_links(IdType id, int level, bool lock, std::vector<IdType>& neighbors) const {
+        std::unique_lock<std::mutex> guard;
+        if (lock) {
+            guard = std::unique_lock<std::mutex>(
+                const_cast<std::mutex&>(link_mutexes_[id])
+            );
+        }
+        const IdType* links = get_links(id, level);
+        neighbors.assign(links + 1, links + 1 + links[0]);
+    }
+
+    /**
+     * greedy search of the closest point in a layer from entry
+    */
+    IdType search_greedy(const DataType* point,
+        IdType entry,
+        int level,
+        bool lock,
+        std::vector<IdType>& neighbors) const {
+
+        DataType entry_dist = distance(point, data_.col(entry).data());
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            copy_links(entry, level, lock, neighbors);
+            for (IdType neighbor : neighbors) {
+                DataType dist = distance(point, data_.col(neighbor).data());
+                if (dist < entry_dist) {
+                    entry_dist = dist;
+                    entry = neighbor;
+                    changed = true;
+                }
+            }
+        }
+        return entry;
+    }
+
+    /**
+     * best-first search in a layer, returns the ef closest points found
+     * sorted by increasing distance
+    */
+    std::vector<NNType> search_layer(const DataType* point,
+        IdType entry,
+        std::size_t ef,
+        int level,
+        bool lock,
+        VisitedList& visited,
+        std::vector<IdType>& neighbors) const {
+
+        MaxHeapType results;
+        MinHeapType candidates;
+        visited.reset(num_points_);
+        visited.visit(entry);
+        DataType entry_dist = distance(point, data_.col(entry).data());
+        results.emplace(entry_dist, entry);
+        candidates.emplace(entry_dist, entry);
+
+        while (!candidates.empty()) {
+            NNType current = candidates.top();
+            if (current.first > results.top().first && results.size() >= ef) {
+                break;
+            }
+            candidates.pop();
+            copy_links(current.second, level, lock, neighbors);
+            for (IdType neighbor : neighbors) {
+                if (!visited.visit(neighbor)) {
+                    continue;
+                }
+                DataType dist = distance(point, data_.col(neighbor).data());
+                if (results.size() < ef || dist < results.top().first) {
+                    candidates.emplace(dist, neighbor);
+                    results.emplace(dist, neighbor);
+                    if (results.size() > ef) {
+                        results.pop();
+                    }
+                }
+            }
+        }
+
+        std::vector<NNType> nns(results.size());
+        for (std::size_t i = nns.size(); i > 0; --i) {
+            nns[i - 1] = results.top();
+            results.pop();
+        }
+        return nns;
+    }
+
+    /**
+     * complete the results of a search that reached fewer than k points,
+     * which happens when pruning leaves layer 0 disconnected. all visited
+     * points are in nns since ef >= k, the k - nns.size() closest points
+     * among the unvisited ones are appended by a linear scan.
+    */
+    void fill_brute_force(const DataType* point,
+        std::size_t k,
+        const VisitedList& visited,
+        std::vector<NNType>& nns) const {
+
+        std::vector<NNType> others;
+        others.reserve(num_points_ - nns.size());
+        for (std::size_t id = 0; id < num_points_; ++id) {
+            if (!visited.is_visited(id)) {
+                others.emplace_back(distance(point, data_.col(id).data()), id);
+            }
+        }
+        std::size_t num_missing = std::min(k - nns.size(), others.size());
+        std::partial_sort(others.begin(), others.begin() + num_missing, others.end());
+        nns.insert(nns.end(), others.begin(), others.begin() + num_missing);
+    }
+
+    /**
+     * neighbor selection heuristic, a candidate is kept only if it is
+     * closer to the point than to every kept neighbor, so that links
+     * go in diverse directions. candidates are sorted by distance.
+    */
+    std::vector<NNType> select_neighbors(const std::vector<NNType>& candidates,
+        std::size_t max_neighbors) const {
+
+        std::vector<NNType> selected;
+        selected.reserve(max_neighbors);
+        for (const NNType& candidate : candidates) {
+            if (selected.size() >= max_neighbors) {
+                break;
+            }
+            bool keep = true;
+            for (const NNType& neighbor : selected) {
+                DataType dist = distance(data_.col(candidate.second).data(),
+                    data_.col(neighbor.second).data());
+                if (dist < candidate.first) {
+                    keep = false;
+                    break;
+                }
+            }
+            if (keep) {
+                selected.push_back(candidate);
+            }
+        }
+        return selected;
+    }
+
+    /**
+     * link the point id in all layers up to its level, neighbors get a
+     * reverse link, a full list is pruned with the selection heuristic
+    */
+    void insert(IdType id, VisitedList& visited, std::vector<IdType>& neighbors) {
+        int level = levels_[id];
+        // the lock is kept if the point becomes the new entry point
+        std::unique_lock<std::mutex> entry_lock(entry_mutex_);
+        int max_level = max_level_;
+        long entry_point = entry_point_;
+        if (entry_point < 0) {
+            entry_point_ = id;
+            max_level_ = level;
+            return ;
+        }
+        if (level <= max_level) {
+            entry_lock.unlock();
+        }
+
+        const DataType* point = data_.col(id).data();
+        IdType entry = entry_point;
+        for (int l = max_level; l > level; --l) {
+            entry = search_greedy(point, entry, l, true, neighbors);
+        }
+
+        for (int l = std::min(level, max_level); l >= 0; --l) {
+            std::vector<NNType> candidates = search_layer(
+                point, entry, ef_construction_, l, true, visited, neighbors
+            );
+            std::vector<NNType> selected = select_neighbors(candidates, M_);
+            {
+                std::lock_guard<std::mutex> guard(link_mutexes_[id]);
+                IdType* links = get_links(id, l);
+                links[0] = selected.size();
+                for (std::size_t i = 0; i < selected.size(); ++i) {
+                    links[i + 1] = selected[i].second;
+                }
+            }
+
+            std::size_t max_links = (l == 0) ? max_M0_ : M_;
+            for (const NNType& neighbor : selected) {
+                std::lock_guard<std::mutex> guard(link_mutexes_[neighbor.second]);
+                IdType* links = get_links(neighbor.second, l);
+                if (links[0] < max_links) {
+                    links[++links[0]] = id;
+                    continue;
+                }
+                const DataType* neighbor_point = data_.col(neighbor.second).data();
+                std::vector<NNType> neighbor_candidates;
+                neighbor_candidates.reserve(max_links + 1);
+                neighbor_candidates.emplace_back(neighbor.first, id);
+                for (IdType i = 1; i <= links[0]; ++i) {
+                    neighbor_candidates.emplace_back(
+                        distance(neighbor_point, data_.col(links[i]).data()), links[i]
+                    );
+                }
+                std::sort(neighbor_candidates.begin(), neighbor_candidates.end());
+                std::vector<NNType> kept = select_neighbors(neighbor_candidates, max_links);
+                links[0] = kept.size();
+                for (std::size_t i = 0; i < kept.size(); ++i) {
+                    links[i + 1] = kept[i].second;
+                }
+            }
+            entry = candidates[0].second;
+        }
+
+        if (level > max_level) {
+            entry_point_ = id;
+            max_level_ = level;
+        }
+    }
+
+public:
+    HNSW(): M_(16),
+        max_M0_(32),
+        ef_construction_(200),
+        ef_search_(50),
+        metric_("euclidean"),
+        cosine_(false),
+        random_state_(-1),
+        n_jobs_(1),
+        level_mult_(1.0 / std::log(16.0)),
+        num_points_(0),
+        entry_point_(-1),
+        max_level_(-1),
+        generator_(random::make_generator(-1)) {};
+
+    HNSW(std::size_t M,
+        std::size_t ef_construction,
+        std::size_t ef_search,
+        std::string metric = "euclidean",
+        long random_state = -1,
+        int n_jobs = 1): M_(M),
+            max_M0_(2 * M),
+            ef_construction_(ef_construction),
+            ef_search_(ef_search),
+            metric_(metric),
+            cosine_(metric == "cosine"),
+            random_state_(random_state),
+            n_jobs_(n_jobs),
+            level_mult_(1.0 / std::log(static_cast<double>(M))),
+            num_points_(0),
+            entry_point_(-1),
+            max_level_(-1),
+            generator_(random::make_generator(random_state)) {
+        if (M < 2) {
+            throw std::invalid_argument("M must be at least 2.");
+        }
+        if (metric != "euclidean" && metric != "cosine") {
+            std::ostringstream err_msg;
+            err_msg << "Metric must be 'euclidean' or 'cosine', but got: "
+                    << metric << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+    };
+
+    ~HNSW() {};
+
+    /**
+     * insert the rows of data into the graph, points are inserted
+     * concurrently, the ids of new points follow the existing ones
+     * @param data ndarray of shape (num_samples, num_features)
+    */
+    void add(const MatType& data) {
+        std::size_t num_new = data.rows(), first = num_points_;
+        if (num_points_ > 0 && data.cols() != data_.rows()) {
+            std::ostringstream err_msg;
+            err_msg << "Expected " << data_.rows() << " features, but got "
+                    << data.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (num_new == 0) {
+            return ;
+        }
+        data_.conservativeResize(data.cols(), first + num_new);
+        data_.middleCols(first, num_new) = transform(data);
+
+        // levels are drawn before the concurrent insertion
+        levels_.resize(first + num_new);
+        upper_links_.resize(first + num_new);
+        for (std::size_t i = first; i < first + num_new; ++i) {
+            double u = random::uniform_real<double>(generator_.next_uint64());
+            levels_[i] = static_cast<int>(-std::log(1 - u) * level_mult_);
+            upper_links_[i].assign(levels_[i] * (M_ + 1), 0);
+            link_mutexes_.emplace_back();
+        }
+        links0_.resize((first + num_new) * (max_M0_ + 1), 0);
+        num_points_ = first + num_new;
+
+        parallel::parallel_for(first, first + num_new, 64, n_jobs_,
+            [&](std::size_t begin, std::size_t end) {
+                // the visited list of the thread is reused across chunks
+                VisitedList& visited = get_visited_list();
+                std::vector<IdType> neighbors;
+                for (std::size_t i = begin; i < end; ++i) {
+                    insert(i, visited, neighbors);
+                }
+            }
+        );
+    }
+
+    /**
+     * approximate k nearest neighbors of a batch of points, queries are
+     * split between threads and written into the output matrices
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param distances output distances sorted by increasing distance
+     * @param indices output ids of the neighbors, if the graph search
+     *      reaches fewer than k points the rest is found by brute force
+    */
+    void query(const MatType& data,
+        std::size_t k,
+        MatType& distances,
+        IdxMatType& indices) const {
+
+        std::size_t num_samples = data.rows();
+        if (k == 0 || k > num_points_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_points of the index, but got k = "
+                    << k << ", num_points = " << num_points_ << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        resize_query_outputs(num_samples, k, distances, indices);
+
+        MatType points = transform(data);
+        std::size_t ef = std::max(ef_search_, k);
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                // the visited list of the thread is reused across chunks
+                VisitedList& visited = get_visited_list();
+                std::vector<IdType> neighbors;
+                for (std::size_t i = first; i < last; ++i) {
+                    const DataType* point = points.col(i).data();
+                    IdType entry = entry_point_;
+                    for (int l = max_level_; l > 0; --l) {
+                        entry = search_greedy(point, entry, l, false, neighbors);
+                    }
+                    std::vector<NNType> nns = search_layer(
+                        point, entry, ef, 0, false, visited, neighbors
+                    );
+                    if (nns.size() < k) {
+                        fill_brute_force(point, k, visited, nns);
+                    }
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(i, j) = to_distance(nns[j].first);
+                        indices(i, j) = nns[j].second;
+                    }
+                }
+            }
+        );
+    }
+
+    const std::pair<MatType, IdxMatType> query(
+        const MatType& data,
+        std::size_t k) const {
+
+        MatType distances;
+        IdxMatType indices;
+        query(data, k, distances, indices);
+        return std::make_pair(distances, indices);
+    }
+
+    /**
+     * save the index into a binary file
+    */
+    void save(const std::string& fp) const {
+        HNSWHeader header;
+        std::memset(&header, 0, sizeof(HNSWHeader));
+        std::memcpy(header.magic, HNSW_MAGIC, sizeof(HNSW_MAGIC));
+        header.version = HNSW_VERSION;
+        header.dtype = data::binary_dtype<DataType>();
+        header.metric = cosine_ ? 1 : 0;
+        header.M = M_;
+        header.ef_construction = ef_construction_;
+        header.num_points = num_points_;
+        header.num_features = data_.rows();
+        header.max_level = max_level_;
+        header.entry_point = entry_point_;
+
+        std::ofstream fout(fp, std::ios::binary | std::ios::trunc);
+        if (!fout) {
+            throw std::runtime_error("Output file could not be opened.");
+        }
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(HNSWHeader));
+        fout.write(reinterpret_cast<const char*>(data_.data()),
+            data_.size() * sizeof(DataType));
+        for (std::size_t i = 0; i < num_points_; ++i) {
+            std::int32_t level = levels_[i];
+            fout.write(reinterpret_cast<const char*>(&level), sizeof(std::int32_t));
+        }
+        fout.write(reinterpret_cast<const char*>(links0_.data()),
+            links0_.size() * sizeof(IdType));
+        for (std::size_t i = 0; i < num_points_; ++i) {
+            fout.write(reinterpret_cast<const char*>(upper_links_[i].data()),
+                upper_links_[i].size() * sizeof(IdType));
+        }
+        if (!fout) {
+            throw std::runtime_error("Could not write output file.");
+        }
+    }
+
+    /**
+     * load an index saved by save, the parameters of the file
+     * replace M, ef_construction and the metric
+    */
+    void load(const std::string& fp) {
+        std::ifstream fin(fp, std::ios::binary);
+        if (!fin) {
+            throw std::runtime_error("Input file could not be opened.");
+        }
+        HNSWHeader header;
+        fin.read(reinterpret_cast<char*>(&header), sizeof(HNSWHeader));
+        if (!fin || std::memcmp(header.magic, HNSW_MAGIC, sizeof(HNSW_MAGIC)) != 0) {
+            throw std::runtime_error("Input file is not a HNSW index.");
+        }
+        if (header.version != HNSW_VERSION ||
+            header.dtype != data::binary_dtype<DataType>()) {
+            std::ostringstream err_msg;
+            err_msg << "Unsupported HNSW version " << header.version
+                    << " or dtype " << static_cast<int>(header.dtype) << std::endl;
+            throw std::runtime_error(err_msg.str());
+        }
+
+        // sizes are checked against the file before any allocation
+        fin.seekg(0, std::ios::end);
+        std::uint64_t remaining = static_cast<std::uint64_t>(fin.tellg()) - sizeof(HNSWHeader);
+        fin.seekg(sizeof(HNSWHeader), std::ios::beg);
+        auto reserve_bytes = [&](std::uint64_t count, std::uint64_t size) {
+            if (count > remaining / size) {
+                throw std::runtime_error("HNSW index file is truncated or corrupt.");
+            }
+            remaining -= count * size;
+        };
+        if (header.M < 2 || 
+            header.num_points > std::numeric_limits<IdType>::max() || 
+            (header.num_points > 0 && header.num_features == 0)) {
+            throw std::runtime_error("HNSW index file has an invalid header.");
+        }
+        bool valid_entry = (header.num_points == 0) ? 
+            (header.entry_point == -1 && header.max_level == -1) : 
+            (header.entry_point >= 0 && 
+                static_cast<std::uint64_t>(header.entry_point) < header.num_points && 
+                header.max_level >= 0);
+        if (!valid_entry) {
+            throw std::runtime_error("HNSW index file has an invalid entry point.");
+        }
+        reserve_bytes(header.num_points, sizeof(std::int32_t));
+        if (header.num_features > remaining / sizeof(DataType) / std::max<std::uint64_t>(header.num_points, 1)) {
+            throw std::runtime_error("HNSW index file is truncated or corrupt.");
+        }
+        reserve_bytes(header.num_points * header.num_features, sizeof(DataType));
+        reserve_bytes(header.num_points, (2 * header.M + 1) * sizeof(IdType));
+
+        M_ = header.M;
+        max_M0_ = 2 * M_;
+        ef_construction_ = header.ef_construction;
+        cosine_ = (header.metric == 1);
+        metric_ = cosine_ ? "cosine" : "euclidean";
+        level_mult_ = 1.0 / std::log(static_cast<double>(M_));
+        num_points_ = header.num_points;
+        max_level_ = header.max_level;
+        entry_point_ = header.entry_point;
+
+        data_.resize(header.num_features, num_points_);
+        fin.read(reinterpret_cast<char*>(data_.data()), data_.size() * sizeof(DataType));
+        levels_.resize(num_points_);
+        for (std::size_t i = 0; i < num_points_; ++i) {
+            std::int32_t level;
+            fin.read(reinterpret_cast<char*>(&level), sizeof(std::int32_t));
+            if (level < 0 || level > max_level_) {
+                throw std::runtime_error("HNSW index file has an invalid point level.");
+            }
+            reserve_bytes(level, (M_ + 1) * sizeof(IdType));
+            levels_[i] = level;
+        }
+        if (num_points_ > 0 && levels_[entry_point_] != max_level_) {
+            throw std::runtime_error("HNSW index file has an invalid entry point.");
+        }
+        links0_.resize(num_points_ * (max_M0_ + 1));
+        fin.read(reinterpret_cast<char*>(links0_.data()), links0_.size() * sizeof(IdType));
+        upper_links_.assign(num_points_, std::vector<IdType>());
+        for (std::size_t i = 0; i < num_points_; ++i) {
+            upper_links_[i].resize(levels_[i] * (M_ + 1));
+            fin.read(reinterpret_cast<char*>(upper_links_[i].data()),
+                upper_links_[i].size() * sizeof(IdType));
+        }
+        if (!fin) {
+            throw std::runtime_error("Could not read input file.");
+        }
+
+        // a neighbor in layer l must exist in that layer
+        for (std::size_t i = 0; i < num_points_; ++i) {
+            for (int l = 0; l <= levels_[i]; ++l) {
+                const IdType* links = get_links(i, l);
+                std::size_t max_links = (l == 0) ? max_M0_ : M_;
+                if (links[0] > max_links) {
+                    throw std::runtime_error("HNSW index file has an invalid link count.");
+                }
+                for (IdType j = 1; j <= links[0]; ++j) {
+                    if (links[j] >= num_points_ || levels_[links[j]] < l) {
+                        throw std::runtime_error("HNSW index file has an invalid link.");
+                    }
+                }
+            }
+        }
+        link_mutexes_.clear();
+        for (std::size_t i = 0; i < num_points_; ++i) {
+            link_mutexes_.emplace_back();
+        }
+    }
+
+    void set_ef_search(std::size_t ef_search) {
+        ef_search_ = ef_search;
+    }
+
+    std::size_t size() const {
+        return num_points_;
+    }
+
+};
+
+}
+}
+#endif /*CORE_TREE_HNSW_HPP*/
@@ -0,0 +1,184 @@
+#ifndef CORE_TREE_KD_FOREST_HPP
+#define CORE_TREE_KD_FOREST_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+
+namespace openml {
+namespace tree {
+
+template<typename DataType>
+class KDTree;
+
+/**
+ * default number of widest dimensions among which the trees of
+ * a forest draw their split dimension
+*/
+constexpr std::size_t KDFOREST_RANDOM_DIMS = 5;
+
+/**
+ * Forest of randomized KD-trees for approximate nearest neighbors,
+ * Silpa-Anan and Hartley 2008 "Optimised KD-trees for fast image
+ * descriptor matching", as in FLANN.
+ *
+ * Every tree indexes all the points but splits a node along a random
+ * dimension among the widest ones of its cell, so the trees partition
+ * the space differently. A query runs a single best-bin-first search
+ * over all trees: the nodes of every tree share one priority queue
+ * ordered by box distance, and a point found in several trees is only
+ * checked once. The search stops after max_checks points, the budget
+ * trades recall for latency, more trees give a better recall for the
+ * same budget.
+ *
+ * @param num_trees size_t, default 4, number of randomized trees
+ * @param leaf_size number of points at which to switch to brute-force
+ * @param metric string, "manhattan", "euclidean" or "chebyshev"
+ * @param random_state long, default -1, seed of the random splits
+ * @param n_jobs number of threads for the construction and the queries,
+ *      default 1, -1 means using all cores
+*/
+template<typename DataType>
+class KDForest {
+private:
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using NNType = std::pair<DataType, std::size_t>;
+
+    std::size_t num_samples_;
+    int n_jobs_;
+    std::vector<std::unique_ptr<KDTree<DataType>>> trees_;
+
+public:
+    KDForest(const MatType& data,
+        std::size_t num_trees = 4,
+        std::size_t leaf_size = 10,
+        std::string metric = "euclidean",
+        long random_state = -1,
+        int n_jobs = 1): num_samples_(data.rows()),
+            n_jobs_(n_jobs) {
+        if (num_trees == 0) {
+            throw std::invalid_argument("num_trees must be positive.");
+        }
+        random::Philox4x32 generator = random::make_generator(random_state);
+        for (std::size_t t = 0; t < num_trees; ++t) {
+            long seed = static_cast<long>(generator.next_uint64() >> 1);
+            trees_.emplace_back(new KDTree<DataType>(
+                data, leaf_size, metric, n_jobs, KDFOREST_RANDOM_DIMS, seed
+            ));
+        }
+    };
+
+    ~KDForest() {};
+
+    /**
+     * approximate k nearest neighbors of a batch of points, queries are
+     * split between threads and written into the output matrices
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param max_checks number of points whose distance is computed
+     *      before stopping, the search goes on until k points are found
+     * @param epsilon double, boxes further than the k-th neighbor divided
+     *      by 1 + epsilon are skipped
+     * @param distances output distances sorted by increasing distance
+     * @param indices output indices of the neighbors in the forest data
+    */
+    void query(const MatType& data,
+        std::size_t k,
+        std::size_t max_checks,
+        double epsilon,
+        MatType& distances,
+        IdxMatType& indices) const {
+
+        std::size_t num_samples = data.rows();
+        if (k == 0 || k > num_samples_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_samples of the forest, but got k = "
+                    << k << ", num_samples = " << num_samples_ << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (epsilon < 0.0) {
+            std::ostringstream err_msg;
+            err_msg << "epsilon must be non-negative, but got " << epsilon << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        resize_query_outputs(num_samples, k, distances, indices);
+
+        const KDTree<DataType>& first_tree = *trees_[0];
+        std::size_t num_trees = trees_.size();
+        DataType scale = first_tree.to_reduced_distance(static_cast<DataType>(1.0 + epsilon));
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(data.cols());
+                std::vector<NNType> heap;
+                // branches as (box distance, node * num_trees + tree)
+                std::vector<NNType> queue;
+                // points checked by the current query, the list of
+                // the thread is reused across chunks and queries
+                VisitedList& visited = get_visited_list();
+                std::size_t tree = 0;
+                heap.reserve(k);
+                auto key = [&](Eigen::Index i) {
+                    if (!visited.visit(i)) {
+                        return -1L;
+                    }
+                    return static_cast<long>(i);
+                };
+                auto push = [&](DataType dist, std::size_t node) {
+                    if (heap.size() < k || dist * scale <= heap.front().first) {
+                        queue.emplace_back(dist, node * num_trees + tree);
+                        std::push_heap(queue.begin(), queue.end(), std::greater<NNType>());
+                    }
+                };
+                for (std::size_t i = first; i < last; ++i) {
+                    visited.reset(num_samples_);
+                    point = data.row(i).transpose();
+                    heap.clear();
+                    queue.clear();
+                    for (std::size_t t = 0; t < num_trees; ++t) {
+                        queue.emplace_back(0, t);
+                    }
+                    std::size_t num_checks = 0;
+                    while (!queue.empty()) {
+                        NNType top = queue.front();
+                        if (heap.size() == k && (num_checks >= max_checks ||
+                            top.first * scale > heap.front().first)) {
+                            break;
+                        }
+                        std::pop_heap(queue.begin(), queue.end(), std::greater<NNType>());
+                        queue.pop_back();
+                        tree = top.second % num_trees;
+                        num_checks += trees_[tree]->descend_single_data(
+                            point, top.second / num_trees, k, key, push, heap
+                        );
+                    }
+                    std::sort_heap(heap.begin(), heap.end());
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(i, j) = first_tree.to_distance(heap[j].first);
+                        indices(i, j) = heap[j].second;
+                    }
+                }
+            }
+        );
+    }
+
+    const std::pair<MatType, IdxMatType> query(
+        const MatType& data,
+        std::size_t k,
+        std::size_t max_checks,
+        double epsilon = 0.0) const {
+
+        MatType distances;
+        IdxMatType indices;
+        query(data, k, max_checks, epsilon, distances, indices);
+        return std::make_pair(distances, indices);
+    }
+
+    std::size_t get_num_trees() const {
+        return trees_.size();
+    }
+
+};
+
+}
+}
+#endif /*CORE_TREE_KD_FOREST_HPP*/
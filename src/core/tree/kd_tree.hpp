@@ -6,375 +6,606 @@
 namespace openml {
 namespace tree {
 
+/**
+ * subtrees of at least this number of points are built in parallel tasks
+*/
+constexpr std::size_t KDTREE_PARALLEL_BUILD_SIZE = 8192;
+
+/**
+ * number of queries of a block of radius queries, the neighbors 
+ * of a block are gathered in a single buffer
+*/
+constexpr std::size_t KDTREE_QUERY_BLOCK_SIZE = 64;
+
+template<typename DataType>
+class DynamicKDTree;
+
+template<typename DataType>
+class KDForest;
+
+/**
+ * KD-tree for nearest neighbors search.
+ *
+ * The tree is stored as flat arrays: nodes only hold the range of their
+ * points, the split and the offsets of their children, bounding boxes
+ * of nodes are columns of two matrices, and points are stored once,
+ * as the columns of a copy of the data reordered in tree order, so the
+ * points of a node are contiguous. Queries only manipulate node indices.
+ *
+ * @param leaf_size number of points at which to switch to brute-force
+ * @param metric string, "manhattan", "euclidean" or "chebyshev"
+ * @param n_jobs number of threads for the construction and the queries,
+ *      default 1, -1 means using all cores
+ * @param num_random_dims size_t, default 0, split a node along a random
+ *      dimension among the num_random_dims widest of its cell, as the
+ *      randomized trees of a KDForest, 0 means along the widest one
+ * @param random_state long, default -1, seed of the random splits
+*/
 template<typename DataType>
-class KDTree {   
+class KDTree {
+    friend class DynamicKDTree<DataType>;
+    friend class KDForest<DataType>;
+
 private:
     using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
     using RowVecType = Eigen::Matrix<DataType, 1, Eigen::Dynamic>;
     using ColVecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
     using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
     using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using SpMatType = Eigen::SparseMatrix<DataType, Eigen::RowMajor>;
     using NNType = std::pair<DataType, std::size_t>;
 
-    struct neighbor_heap_cmp {
-        bool operator()(const NNType &x, const NNType &y) {
-            return x.first < y.first;
-        }
-    };
-    using NNHeapType = std::priority_queue<NNType, std::vector<NNType>, neighbor_heap_cmp>;
-
+    /**
+     * points of a node are the columns [begin, end) of data_,
+     * a leaf has no children, left = right = -1
+    */
     struct KDTreeNode {
-        int left;
-        int right;
-        std::shared_ptr<MatType> data;
-        std::shared_ptr<IdxVecType> indices;
-        std::shared_ptr<MatType> left_hyper_rect;
-        std::shared_ptr<MatType> right_hyper_rect;
-
-        KDTreeNode(): left(-1), 
-            right(-1), 
-            data(nullptr),
-            indices(nullptr), 
-            left_hyper_rect(nullptr), 
-            right_hyper_rect(nullptr) {};
-
-        KDTreeNode(int left_, 
-            int right_, 
-            std::shared_ptr<MatType> data_, 
-            std::shared_ptr<IdxVecType> indices_,
-            std::shared_ptr<MatType> left_hyper_rect_, 
-            std::shared_ptr<MatType> right_hyper_rect_): 
-                left(left_), 
-                right(right_), 
-                data(data_), 
-                indices(indices_), 
-                left_hyper_rect(left_hyper_rect_), 
-                right_hyper_rect(right_hyper_rect_) {};
-        
-        ~KDTreeNode() {};
+        std::size_t begin;
+        std::size_t end;
+        long left;
+        long right;
+        std::size_t split_dim;
+        DataType split_val;
     };
 
-    struct NodeInfo {
-        bool is_left;
-        std::size_t depth;
-        std::size_t index;
-        IdxVecType indices;
-        MatType data;
+    /**
+     * state of a dual-tree all k nearest neighbors search, the heap of 
+     * the point i of the tree is heaps[i * k, i * k + sizes[i]), the
+     * largest and the smallest k-th distances of the points of a node
+     * give its bound, infinite while a heap is not full
+    */
+    struct DualTreeState {
+        std::size_t k;
+        std::vector<NNType> heaps;
+        std::vector<std::size_t> sizes;
+        std::vector<DataType> max_kth;
+        std::vector<DataType> min_kth;
+        std::vector<DataType> bounds;
     };
 
     int ord_;
-    MatType data_;
     std::string metric_;
     std::size_t leaf_size_;
-    std::shared_ptr<std::vector<KDTreeNode>> tree_;
-    
-protected:
-    const std::size_t find_partition_axis(const MatType& data) const {
-        std::size_t num_samples = data.rows(), num_features = data.cols();
-        std::vector<DataType> range_bounds(num_features);
-        std::vector<DataType> lower_bounds(num_features, ConstType<DataType>::infinity());
-        std::vector<DataType> upper_bounds(num_features, -ConstType<DataType>::infinity());
+    int n_jobs_;
+    std::size_t num_random_dims_;
+    random::Philox4x32 generator_;
+
+    // points in tree order, one point per column. The distance to a
+    // point is a single packet (SIMD) reduction over its contiguous
+    // coordinates, feature-major leaf buckets with early abandoned partial
+    // sums were measured slower: they need padded buckets and a load and 
+    // store of the partial sums per feature
+    MatType data_;
+    // original index of each column of data_
+    IdxVecType indices_;
+    std::vector<KDTreeNode> nodes_;
+    // bounding box of each node, one column per node
+    MatType lower_bounds_;
+    MatType upper_bounds_;
 
-        for (std::size_t i = 0; i < num_samples; ++i) {
-            for (std::size_t j = 0; j < num_features; ++j) {
-                lower_bounds[j] = std::min(lower_bounds[j], data(i, j));
-                upper_bounds[j] = std::max(upper_bounds[j], data(i, j));
-            }
+protected:
+    /**
+     * distance reduced from a vector of coordinate differences, the
+     * euclidean distance is squared to avoid a square root per point
+    */
+    template<typename DiffType>
+    DataType reduce_distance(const Eigen::MatrixBase<DiffType>& diff) const {
+        if (ord_ == 2) {
+            return diff.squaredNorm();
         }
-
-        std::size_t partition_axis = 0;
-        for (std::size_t i = 0; i < num_features; ++i) {
-            range_bounds[i] = std::abs(upper_bounds[i] - lower_bounds[i]);
-            if (range_bounds[i] > range_bounds[partition_axis]) {
-                partition_axis = i;
-            }
+        else if (ord_ == 1) {
+            return diff.cwiseAbs().sum();
         }
-        return partition_axis;
-    };
+        return diff.cwiseAbs().maxCoeff();
+    }
 
-    void build_tree() {
-        tree_ = std::make_shared<std::vector<KDTreeNode>>();
-        MatType data = data_;
-        std::size_t num_samples = data.rows(), num_features = data.cols();
+    DataType to_distance(DataType rdist) const {
+        return (ord_ == 2) ? std::sqrt(rdist) : rdist;
+    }
 
-        // find bounding hyper-rectangle
-        MatType hyper_rect(2, num_features);
-        hyper_rect.row(0) = data.colwise().minCoeff();
-        hyper_rect.row(1) = data.colwise().maxCoeff();
-
-        // create root of kd-tree
-        // find the partition axis via function find_partition_axis
-        // the sort data along the partition axis 
-        std::size_t partition_axis = find_partition_axis(data);
-        IdxVecType indices = common::argsort<MatType, IdxMatType, IdxVecType>(
-            data.col(partition_axis), 0
-        );
-        data = data(indices, Eigen::all).eval();
-        std::size_t mid_idx = num_samples / 2;
-        std::size_t left_num_samples = mid_idx;
-        std::size_t right_num_samples = num_samples - mid_idx;
-        DataType partition_val = data(mid_idx, partition_axis);
-
-        // define left_hyper_rect and right_hyper_rect
-        MatType left_hyper_rect = hyper_rect;
-        MatType right_hyper_rect = hyper_rect;
-        left_hyper_rect(1, 0) = partition_val;
-        right_hyper_rect(0, 0) = partition_val;
-
-        KDTreeNode node; //std::make_shared<>();
-        node.left_hyper_rect = std::make_shared<MatType>(left_hyper_rect);
-        node.right_hyper_rect = std::make_shared<MatType>(right_hyper_rect);
-        tree_->emplace_back(node);
-
-        // create a stack to restore data, indice, parent indice, depth and is_left
-        NodeInfo init_node_info1, init_node_info2;
-        init_node_info1.is_left = true;
-        init_node_info1.depth = 1;
-        init_node_info1.index = 0;
-        init_node_info1.data = data.topRows(left_num_samples);
-        init_node_info1.indices = indices.head(left_num_samples);
-
-        init_node_info2.is_left = false;
-        init_node_info2.depth = 1;
-        init_node_info2.index = 0;
-        init_node_info2.data = data.bottomRows(right_num_samples);
-        init_node_info2.indices = indices.tail(right_num_samples);
-
-        std::stack<NodeInfo> node_info_stk;
-        node_info_stk.push(init_node_info1);
-        node_info_stk.push(init_node_info2);
-
-        // recursively split data in halves using hyper-rectangles:
-        while (!node_info_stk.empty()) {
-            // pop data off stack
-            NodeInfo curr_node_info = node_info_stk.top();
-            node_info_stk.pop();
-
-            std::size_t curr_num_samples = curr_node_info.data.rows();
-            std::size_t node_ptr = tree_->size();
-
-            // update parent node index
-            KDTreeNode curr_node = tree_->at(curr_node_info.index);
-            if (curr_node_info.is_left) {
-                tree_->at(curr_node_info.index).left = node_ptr;
-            }
-            else {
-                tree_->at(curr_node_info.index).right = node_ptr;
-            }
+    DataType to_reduced_distance(DataType dist) const {
+        return (ord_ == 2) ? dist * dist : dist;
+    }
 
-            // insert node in kd-tree
-            // leaf node ? create leaf node
-            if (curr_num_samples <= leaf_size_) {
-                KDTreeNode leaf_node;
-                leaf_node.data = std::make_shared<MatType>(curr_node_info.data);
-                leaf_node.indices = std::make_shared<IdxVecType>(curr_node_info.indices);
-                leaf_node.left_hyper_rect = nullptr;
-                leaf_node.right_hyper_rect = nullptr;
-                leaf_node.left = 0;
-                leaf_node.right = 0;
-                tree_->emplace_back(leaf_node);
-            }
-            // not a leaf, split the data in two
-            else {
-                IdxVecType data_indices;
-                // split the data in two left_samples and right_samples
-                std::size_t curr_mid_idx = curr_num_samples / 2;
-                std::size_t curr_left_num_samples = curr_mid_idx;
-                std::size_t curr_right_num_samples = curr_num_samples - curr_mid_idx;
-
-                // find the partition axis, sort data along the partition axis
-                partition_axis = find_partition_axis(curr_node_info.data);
-                indices = common::argsort<MatType, IdxMatType, IdxVecType>(
-                    curr_node_info.data.col(partition_axis), 0
-                );
-                data = curr_node_info.data(indices, Eigen::all).eval();
-                data_indices = curr_node_info.indices(indices);
-                partition_val = data(curr_mid_idx, partition_axis);
-                node_ptr = tree_->size();
-
-                // push updated data, indices, index and current depth into stack
-                NodeInfo update_stk_data1, update_stk_data2;
-                update_stk_data1.is_left = true;
-                update_stk_data1.depth++;
-                update_stk_data1.index = node_ptr;
-                update_stk_data1.data = data.topRows(curr_left_num_samples);
-                update_stk_data1.indices = data_indices.head(curr_left_num_samples);
-
-                update_stk_data2.is_left = false;
-                update_stk_data2.depth++;
-                update_stk_data2.index = node_ptr;
-                update_stk_data2.data = data.bottomRows(curr_right_num_samples);
-                update_stk_data2.indices = data_indices.tail(curr_right_num_samples);
-
-                node_info_stk.push(update_stk_data1);
-                node_info_stk.push(update_stk_data2);
-
-                if (curr_node_info.is_left) {
-                    left_hyper_rect = *curr_node.left_hyper_rect;
-                    right_hyper_rect = *curr_node.left_hyper_rect;
-                }
-                else {
-                    left_hyper_rect = *curr_node.right_hyper_rect;
-                    right_hyper_rect = *curr_node.right_hyper_rect;
-                }
+    /**
+     * reduced distance between a point and the bounding box of a node,
+     * 0 if the point is inside the box
+    */
+    template<typename PointType>
+    DataType min_box_distance(const Eigen::MatrixBase<PointType>& point, std::size_t node) const {
+        return reduce_distance(
+            (lower_bounds_.col(node) - point).cwiseMax(static_cast<DataType>(0)) +
+            (point - upper_bounds_.col(node)).cwiseMax(static_cast<DataType>(0))
+        );
+    }
 
-                left_hyper_rect(1, partition_axis) = partition_val;
-                right_hyper_rect(0, partition_axis) = partition_val;
+    /**
+     * reduced distance between the bounding boxes of two nodes
+    */
+    DataType min_node_distance(std::size_t node1, std::size_t node2) const {
+        return reduce_distance(
+            (lower_bounds_.col(node2) - upper_bounds_.col(node1)).cwiseMax(static_cast<DataType>(0)) +
+            (lower_bounds_.col(node1) - upper_bounds_.col(node2)).cwiseMax(static_cast<DataType>(0))
+        );
+    }
 
-                // create non_leaf node
-                KDTreeNode branch_node;
-                branch_node.left_hyper_rect = std::make_shared<MatType>(left_hyper_rect);
-                branch_node.right_hyper_rect = std::make_shared<MatType>(right_hyper_rect);
-                tree_->emplace_back(branch_node);
-            }   
+    /**
+     * number of nodes of the subtrees of num_samples and num_samples + 1
+     * points, subtrees at the same depth differ by at most one point,
+     * so the pair only depends on the pair of the half size
+    */
+    std::pair<std::size_t, std::size_t> count_nodes(std::size_t num_samples) const {
+        std::size_t leaf_size = std::max<std::size_t>(leaf_size_, 1);
+        if (num_samples + 1 <= leaf_size) {
+            return std::make_pair(1, 1);
         }
+        std::size_t half = num_samples / 2;
+        std::pair<std::size_t, std::size_t> half_count = count_nodes(half);
+        std::size_t count, next_count;
+        if (num_samples % 2 == 0) {
+            count = 1 + 2 * half_count.first;
+            next_count = 1 + half_count.first + half_count.second;
+        }
+        else {
+            count = 1 + half_count.first + half_count.second;
+            next_count = 1 + 2 * half_count.second;
+        }
+        if (num_samples <= leaf_size) {
+            count = 1;
+        }
+        return std::make_pair(count, next_count);
     }
 
-    const bool check_intersection(const MatType& hyper_rect, 
-        const RowVecType& centroid, 
-        double radius) const {
-
-        RowVecType lower_bounds = hyper_rect.row(0);
-        RowVecType upper_bounds = hyper_rect.row(1);
-        RowVecType c = centroid;
+    /**
+     * reduced distance between a point and the furthest
+     * vertex of the bounding box of a node
+    */
+    DataType max_box_distance(const ColVecType& point, std::size_t node) const {
+        return reduce_distance(
+            (point - lower_bounds_.col(node)).cwiseAbs().cwiseMax(
+                (point - upper_bounds_.col(node)).cwiseAbs())
+        );
+    }
 
-        for (int i = 0; i < c.cols(); ++i) {
-            if (c(0, i) > upper_bounds(0, i)) {
-                c(0, i) = upper_bounds(0, i);
+    /**
+     * build the subtree of root index over the points order[begin, end).
+     * Nodes are in preorder, the size of the left subtree is known from
+     * the number of points, so both subtrees are written independently
+     * and large subtrees are built in parallel.
+     *
+     * The split dimension is the widest of the cell of the node, the cell
+     * being the box of the parent cut at the split value, the points are
+     * partitioned in place at the median with nth_element, the bounding
+     * box is computed from the points for a leaf, from the children else.
+    */
+    void build_node(const MatType& data,
+        std::vector<Eigen::Index>& order,
+        std::size_t index,
+        std::size_t begin,
+        std::size_t end,
+        ColVecType cell_lower,
+        ColVecType cell_upper,
+        parallel::ThreadPool* pool) {
+
+        KDTreeNode& node = nodes_[index];
+        node.begin = begin;
+        node.end = end;
+        node.left = -1;
+        node.right = -1;
+        node.split_dim = 0;
+        node.split_val = 0;
+
+        if (end - begin <= std::max<std::size_t>(leaf_size_, 1)) {
+            lower_bounds_.col(index).setConstant(ConstType<DataType>::infinity());
+            upper_bounds_.col(index).setConstant(-ConstType<DataType>::infinity());
+            for (std::size_t i = begin; i < end; ++i) {
+                lower_bounds_.col(index) = lower_bounds_.col(index).cwiseMin(data.row(order[i]).transpose());
+                upper_bounds_.col(index) = upper_bounds_.col(index).cwiseMax(data.row(order[i]).transpose());
             }
-            if (c(0, i) < lower_bounds(0, i)) {
-                c(0, i) = lower_bounds(0, i);
-            } 
+            return ;
         }
 
-        double dist = metric::minkowski_distance<RowVecType>(c, centroid, ord_);
-        return (dist < radius) ? true : false;
+        Eigen::Index split_dim;
+        ColVecType widths = cell_upper - cell_lower;
+        widths.maxCoeff(&split_dim);
+        if (num_random_dims_ > 1 && widths(split_dim) > 0) {
+            // the draw of a node only depends on its index, not on the 
+            // order in which parallel tasks build the nodes
+            std::vector<Eigen::Index> dims(widths.size());
+            std::iota(dims.begin(), dims.end(), 0);
+            std::size_t num_dims = std::min<std::size_t>(num_random_dims_, dims.size());
+            std::partial_sort(dims.begin(), dims.begin() + num_dims, dims.end(),
+                [&widths](Eigen::Index i, Eigen::Index j) {
+                    return widths(i) > widths(j);
+                }
+            );
+            while (widths(dims[num_dims - 1]) <= 0) {
+                --num_dims;
+            }
+            random::Philox4x32 generator = generator_.substream(index);
+            split_dim = dims[random::uniform_index(generator, num_dims)];
+        }
+        std::size_t mid = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+            [&data, split_dim](Eigen::Index i, Eigen::Index j) {
+                return data(i, split_dim) < data(j, split_dim);
+            }
+        );
+        DataType split_val = data(order[mid], split_dim);
+        std::size_t left = index + 1;
+        std::size_t right = left + count_nodes(mid - begin).first;
+        node.split_dim = split_dim;
+        node.split_val = split_val;
+        node.left = left;
+        node.right = right;
+
+        ColVecType left_upper = cell_upper, right_lower = cell_lower;
+        left_upper(split_dim) = split_val;
+        right_lower(split_dim) = split_val;
+        {
+            // a null pool or a small subtree builds the left subtree inline
+            bool spawn = (end - begin >= KDTREE_PARALLEL_BUILD_SIZE);
+            parallel::TaskGroup group(spawn ? pool : nullptr);
+            group.run([&, left, begin, mid]() {
+                build_node(data, order, left, begin, mid, cell_lower, left_upper, pool);
+            });
+            build_node(data, order, right, mid, end, right_lower, cell_upper, pool);
+            group.wait();
+        }
+        lower_bounds_.col(index) = lower_bounds_.col(left).cwiseMin(lower_bounds_.col(right));
+        upper_bounds_.col(index) = upper_bounds_.col(left).cwiseMax(upper_bounds_.col(right));
     }
 
-    const std::vector<NNType> compute_distance(const RowVecType& data, 
-        const MatType& leaf_data,
-        const IdxVecType& leaf_indices, 
-        std::size_t k) const {
-
-        std::size_t num_samples = leaf_data.rows();
-        if (k >= num_samples) {
-            k = num_samples;
+    void build_tree(const MatType& data) {
+        std::size_t num_samples = data.rows(), num_features = data.cols();
+        if (num_samples == 0) {
+            throw std::invalid_argument("Cannot build a KDTree without data.");
         }
+        std::vector<Eigen::Index> order(num_samples);
+        std::iota(order.begin(), order.end(), 0);
+
+        std::size_t num_nodes = count_nodes(num_samples).first;
+        nodes_.resize(num_nodes);
+        lower_bounds_.resize(num_features, num_nodes);
+        upper_bounds_.resize(num_features, num_nodes);
+
+        std::size_t num_jobs = parallel::get_num_jobs(n_jobs_);
+        parallel::ThreadPool* pool = (num_jobs > 1) ? &parallel::get_thread_pool(num_jobs) : nullptr;
+        ColVecType cell_lower = data.colwise().minCoeff().transpose();
+        ColVecType cell_upper = data.colwise().maxCoeff().transpose();
+        build_node(data, order, 0, 0, num_samples, cell_lower, cell_upper, pool);
+
+        indices_ = Eigen::Map<IdxVecType>(order.data(), num_samples);
+        data_ = data(order, Eigen::all).transpose();
+    }
 
-        // compute difference between leaf data and single data points
-        MatType tmp = leaf_data.rowwise() - data;
-        ColVecType dist = common::norm<MatType>(tmp, 1, ord_);
-        IdxVecType indices = common::argsort<MatType, IdxMatType, IdxVecType>(dist, 0);
-        indices = indices.head(k).eval();
-
-        std::vector<NNType> knn;
-        for (int i = 0; i < k; ++i) {
-            knn.emplace_back(
-                std::make_pair(dist(indices(i), 0), leaf_indices(indices(i)))
-            );
+    /**
+     * push a candidate into a max-heap of at most k neighbors
+    */
+    static void push_neighbor(std::vector<NNType>& heap, std::size_t k, const NNType& nn) {
+        if (heap.size() < k) {
+            heap.push_back(nn);
+            std::push_heap(heap.begin(), heap.end());
+        }
+        else if (nn < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = nn;
+            std::push_heap(heap.begin(), heap.end());
         }
-        return knn;
     }
 
-    const std::vector<NNType> query_single_data(
-        const RowVecType& data, 
-        std::size_t k) const {
+    /**
+     * k nearest neighbors of a single point merged into heap, a max-heap 
+     * of (reduced distance, key) pairs which may already hold neighbors
+     * and then bounds the search. key(i) gives the key of the point of
+     * the row i of the data of the tree, a negative key skips the point.
+    */
+    template<typename KeyFunction>
+    void search_single_data(const ColVecType& point,
+        std::size_t k,
+        const KeyFunction& key,
+        std::vector<NNType>& heap,
+        std::vector<std::size_t>& node_stack) const {
+
+        node_stack.clear();
+        node_stack.push_back(0);
+        while (!node_stack.empty()) {
+            std::size_t node = node_stack.back();
+            node_stack.pop_back();
+            if (heap.size() == k && min_box_distance(point, node) > heap.front().first) {
+                continue;
+            }
 
-        std::stack<KDTreeNode> node_stk;
-        node_stk.push(tree_->at(0));
-
-        std::vector<NNType> knn(k);
-        NNHeapType nn_heap;
-        for (std::size_t i = 0; i < k; ++i) {
-            nn_heap.push(std::make_pair(ConstType<DataType>::infinity(), 0));
-        }
-
-        // recursively iterate over the nodes
-        while (!node_stk.empty()) {
-            KDTreeNode node = node_stk.top();
-            node_stk.pop();
-            if (node.indices != nullptr) {
-                std::vector<NNType> single_knn = compute_distance(
-                    data, *node.data, *node.indices, k
-                );
-                // push nn into min priority queue 
-                for (auto iter = single_knn.begin(); iter != single_knn.end(); iter++) {
-                    nn_heap.push(*iter);
-                    // if heap size > k, pop top element, keep the size = k
-                    if (nn_heap.size() > k) { 
-                        nn_heap.pop();
+            const KDTreeNode& info = nodes_[node];
+            if (info.left < 0) {
+                for (std::size_t i = info.begin; i < info.end; ++i) {
+                    long id = key(indices_(i));
+                    if (id < 0) {
+                        continue;
                     }
+                    push_neighbor(heap, k, NNType(reduce_distance(data_.col(i) - point), id));
                 }
+                continue;
+            }
+            // visit the child on the side of the point first
+            if (point(info.split_dim) < info.split_val) {
+                node_stack.push_back(info.right);
+                node_stack.push_back(info.left);
             }
             else {
-                DataType radius = nn_heap.top().first;
-                // check left branch
-                if (check_intersection(*node.left_hyper_rect, data, radius)) {
-                    node_stk.push(tree_->at(node.left));
-                }
-                // chech right branch
-                if (check_intersection(*node.right_hyper_rect, data, radius)) {
-                    node_stk.push(tree_->at(node.right));
-                }
+                node_stack.push_back(info.left);
+                node_stack.push_back(info.right);
             }
         }
-        // Find the first K smaller elements
-        for (int i = k - 1; i >= 0; i--) {
-            knn[i] = std::make_pair(nn_heap.top().first, nn_heap.top().second);
-            nn_heap.pop();
+    }
+
+    /**
+     * best-bin-first step, descend from node to a leaf on the side of the
+     * point, the other child of each node on the way is passed to 
+     * push(reduced box distance, node), the points of the leaf are merged
+     * into heap as in search_single_data
+     * @return number of points whose distance was computed
+    */
+    template<typename KeyFunction, typename PushFunction>
+    std::size_t descend_single_data(const ColVecType& point,
+        std::size_t node,
+        std::size_t k,
+        const KeyFunction& key,
+        const PushFunction& push,
+        std::vector<NNType>& heap) const {
+
+        while (nodes_[node].left >= 0) {
+            const KDTreeNode& info = nodes_[node];
+            std::size_t near = info.left, far = info.right;
+            if (point(info.split_dim) >= info.split_val) {
+                std::swap(near, far);
+            }
+            push(min_box_distance(point, far), far);
+            node = near;
         }
-        return knn;
+        std::size_t num_checks = 0;
+        for (std::size_t i = nodes_[node].begin; i < nodes_[node].end; ++i) {
+            long id = key(indices_(i));
+            if (id < 0) {
+                continue;
+            }
+            push_neighbor(heap, k, NNType(reduce_distance(data_.col(i) - point), id));
+            ++num_checks;
+        }
+        return num_checks;
     }
 
-    const std::vector<NNType> query_radius_single_data(const RowVecType& data,
-        double radius) const {
-        
-        std::stack<KDTreeNode> node_stk;
-        node_stk.push(tree_->at(0));
-        std::vector<NNType> knn;
-        // recursively iterate over the nodes
-        while (!node_stk.empty()) {
-            KDTreeNode node = node_stk.top();
-            node_stk.pop();
-
-            if (node.indices != nullptr) {
-                MatType tmp = (*node.data).rowwise() - data;
-                ColVecType dist = common::norm<MatType>(tmp, 1, ord_);
-
-                std::vector<Eigen::Index> selected_indices;
-                auto selected_dist = (dist.array() <= static_cast<DataType>(radius));
-                for (std::size_t i = 0; i < selected_dist.size(); ++i) {
-                    if (selected_dist(i, 0)) {
-                        selected_indices.push_back(i);
+    /**
+     * k nearest neighbors of a single point, heap and node_stack are
+     * buffers reused between queries, on return heap holds the
+     * neighbors sorted by increasing reduced distance
+    */
+    void query_single_data(const ColVecType& point,
+        std::size_t k,
+        std::vector<NNType>& heap,
+        std::vector<std::size_t>& node_stack) const {
+
+        heap.clear();
+        search_single_data(point, k, [](Eigen::Index i) { return static_cast<long>(i); }, heap, node_stack);
+        std::sort_heap(heap.begin(), heap.end());
+    }
+
+    /**
+     * neighbors of a single point within the reduced radius,
+     * appended to nns in tree order
+    */
+    void query_radius_single_data(const ColVecType& point,
+        DataType rradius,
+        std::vector<NNType>& nns,
+        std::vector<std::size_t>& node_stack) const {
+
+        node_stack.clear();
+        node_stack.push_back(0);
+        while (!node_stack.empty()) {
+            std::size_t node = node_stack.back();
+            node_stack.pop_back();
+            if (min_box_distance(point, node) > rradius) {
+                continue;
+            }
+
+            const KDTreeNode& info = nodes_[node];
+            if (info.left < 0) {
+                for (std::size_t i = info.begin; i < info.end; ++i) {
+                    DataType rdist = reduce_distance(data_.col(i) - point);
+                    if (rdist <= rradius) {
+                        nns.emplace_back(to_distance(rdist), indices_(i));
                     }
                 }
-                if (!selected_indices.empty()) {
-                    for (auto idx : selected_indices) {
-                        auto index = (*node.indices)(idx);
-                        auto distance = dist(idx, 0);
-                        knn.emplace_back(std::make_pair(distance, index));
+                continue;
+            }
+            node_stack.push_back(info.right);
+            node_stack.push_back(info.left);
+        }
+    }
+
+    /**
+     * number of neighbors of a single point within the reduced radius,
+     * a node whose box is entirely inside the radius is counted at once
+    */
+    std::size_t count_radius_single_data(const ColVecType& point,
+        DataType rradius,
+        std::vector<std::size_t>& node_stack) const {
+
+        std::size_t count = 0;
+        node_stack.clear();
+        node_stack.push_back(0);
+        while (!node_stack.empty()) {
+            std::size_t node = node_stack.back();
+            node_stack.pop_back();
+            if (min_box_distance(point, node) > rradius) {
+                continue;
+            }
+
+            const KDTreeNode& info = nodes_[node];
+            if (max_box_distance(point, node) <= rradius) {
+                count += info.end - info.begin;
+                continue;
+            }
+            if (info.left < 0) {
+                for (std::size_t i = info.begin; i < info.end; ++i) {
+                    if (reduce_distance(data_.col(i) - point) <= rradius) {
+                        ++count;
                     }
                 }
+                continue;
             }
-            else {
-                // check left branch
-                if (check_intersection(*node.left_hyper_rect, data, radius)) {
-                    node_stk.push(tree_->at(node.left));
+            node_stack.push_back(info.right);
+            node_stack.push_back(info.left);
+        }
+        return count;
+    }
+
+    /**
+     * bound of a query node, no point of the node has a k-th distance
+     * larger than the largest k-th distance, nor than the smallest one
+     * plus the diameter of the node: the k neighbors of the point q with
+     * the smallest k-th distance, or q itself for one of them, are within
+     * this distance of any other point of the node
+    */
+    void update_bound(std::size_t node,
+        DataType max_kth,
+        DataType min_kth,
+        DualTreeState& state) const {
+
+        state.max_kth[node] = max_kth;
+        state.min_kth[node] = min_kth;
+        DataType diameter = to_distance(reduce_distance(upper_bounds_.col(node) - lower_bounds_.col(node)));
+        state.bounds[node] = std::min(max_kth, to_reduced_distance(to_distance(min_kth) + diameter));
+    }
+
+    /**
+     * all pairs of points of a query leaf and a reference leaf, a point 
+     * is not its own neighbor, the bound of the query leaf is updated
+    */
+    void dual_tree_base_case(std::size_t query_node,
+        std::size_t ref_node,
+        DualTreeState& state) const {
+
+        const KDTreeNode& query = nodes_[query_node];
+        const KDTreeNode& ref = nodes_[ref_node];
+        std::size_t k = state.k;
+        DataType max_kth = 0, min_kth = ConstType<DataType>::infinity();
+        for (std::size_t i = query.begin; i < query.end; ++i) {
+            NNType* heap = &state.heaps[i * k];
+            std::size_t& size = state.sizes[i];
+            if (size == k && min_box_distance(data_.col(i), ref_node) > heap[0].first) {
+                max_kth = std::max(max_kth, heap[0].first);
+                min_kth = std::min(min_kth, heap[0].first);
+                continue;
+            }
+            for (std::size_t j = ref.begin; j < ref.end; ++j) {
+                if (j == i) {
+                    continue;
+                }
+                NNType nn(reduce_distance(data_.col(j) - data_.col(i)), j);
+                if (size < k) {
+                    heap[size++] = nn;
+                    std::push_heap(heap, heap + size);
                 }
-                // chech right branch
-                if (check_intersection(*node.right_hyper_rect, data, radius)) {
-                    node_stk.push(tree_->at(node.right));
+                else if (nn < heap[0]) {
+                    std::pop_heap(heap, heap + k);
+                    heap[k - 1] = nn;
+                    std::push_heap(heap, heap + k);
                 }
             }
+            DataType kth = (size < k) ? ConstType<DataType>::infinity() : heap[0].first;
+            max_kth = std::max(max_kth, kth);
+            min_kth = std::min(min_kth, kth);
         }
-        return knn;
+        update_bound(query_node, max_kth, min_kth, state);
+    }
+
+    /**
+     * visit the children of a reference node, the closest first
+    */
+    void dual_tree_ref_children(std::size_t query_node,
+        std::size_t ref_node,
+        DualTreeState& state) const {
+
+        std::size_t first = nodes_[ref_node].left, second = nodes_[ref_node].right;
+        if (min_node_distance(query_node, second) < min_node_distance(query_node, first)) {
+            std::swap(first, second);
+        }
+        dual_tree_node(query_node, first, state);
+        dual_tree_node(query_node, second, state);
+    }
+
+    /**
+     * dual-tree traversal, Curtin et al. 2013 "Tree-independent dual-tree
+     * algorithms". A pair of nodes is pruned when the distance between
+     * their boxes exceeds the bound of the query node, else both internal
+     * nodes are split, the closer reference child is visited first. Bounds
+     * only decrease, so the bound of a parent, recomputed when its
+     * children are done, stays valid in between.
+    */
+    void dual_tree_node(std::size_t query_node,
+        std::size_t ref_node,
+        DualTreeState& state) const {
+
+        if (min_node_distance(query_node, ref_node) > state.bounds[query_node]) {
+            return ;
+        }
+        const KDTreeNode& query = nodes_[query_node];
+        const KDTreeNode& ref = nodes_[ref_node];
+        if (query.left < 0 && ref.left < 0) {
+            dual_tree_base_case(query_node, ref_node, state);
+            return ;
+        }
+        if (query.left < 0) {
+            dual_tree_ref_children(query_node, ref_node, state);
+            return ;
+        }
+        if (ref.left < 0) {
+            dual_tree_node(query.left, ref_node, state);
+            dual_tree_node(query.right, ref_node, state);
+        }
+        else {
+            dual_tree_ref_children(query.left, ref_node, state);
+            dual_tree_ref_children(query.right, ref_node, state);
+        }
+        update_bound(query_node, 
+            std::max(state.max_kth[query.left], state.max_kth[query.right]),
+            std::min(state.min_kth[query.left], state.min_kth[query.right]), 
+            state);
     }
 
 public:
-    KDTree(const MatType& data, 
-        std::size_t leaf_size, 
-        std::string metric): data_(data), 
-            leaf_size_(leaf_size), metric_(metric) {
+    KDTree(const MatType& data,
+        std::size_t leaf_size,
+        std::string metric,
+        int n_jobs = 1,
+        std::size_t num_random_dims = 0,
+        long random_state = -1): metric_(metric),
+            leaf_size_(leaf_size),
+            n_jobs_(n_jobs),
+            num_random_dims_(num_random_dims),
+            generator_(num_random_dims > 1 ? 
+                random::make_generator(random_state) : random::Philox4x32()) {
         if (metric == "manhattan") {
             ord_ = 1;
         }
@@ -384,64 +615,350 @@ public:
         else if (metric == "chebyshev") {
             ord_ = Eigen::Infinity;
         }
+        else {
+            std::ostringstream err_msg;
+            err_msg << "Metric must be 'manhattan', 'euclidean' or 'chebyshev', "
+                    << "but got: " << metric << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
 
-        build_tree();
+        build_tree(data);
     };
 
-    KDTree(const MatType& data): 
-        data_(data), leaf_size_(10), metric_("euclidean") {
-            ord_ = 2;
-            build_tree();
+    KDTree(const MatType& data): ord_(2),
+        metric_("euclidean"),
+        leaf_size_(10),
+        n_jobs_(1),
+        num_random_dims_(0) {
+            build_tree(data);
         };
 
-    ~KDTree() {
-        if (tree_ != nullptr) {
-            tree_->clear();
+    ~KDTree() {};
+
+    /**
+     * k nearest neighbors of a batch of points, queries are split
+     * between threads and written into the preallocated output matrices,
+     * which are only resized if their shape is not (num_samples, k)
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param distances output distances sorted by increasing distance
+     * @param indices output indices of the neighbors in the tree data
+    */
+    void query(const MatType& data,
+        std::size_t k,
+        MatType& distances,
+        IdxMatType& indices) const {
+
+        std::size_t num_samples = data.rows();
+        if (k == 0 || k > static_cast<std::size_t>(data_.cols())) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_samples of the tree, but got k = "
+                    << k << ", num_samples = " << data_.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
         }
-    };
+        resize_query_outputs(num_samples, k, distances, indices);
+
+        // each query writes its own row, queries are independent,
+        // buffers are allocated once per range of queries
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(data.cols());
+                std::vector<NNType> heap;
+                std::vector<std::size_t> node_stack;
+                heap.reserve(k);
+                for (std::size_t i = first; i < last; ++i) {
+                    point = data.row(i).transpose();
+                    query_single_data(point, k, heap, node_stack);
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(i, j) = to_distance(heap[j].first);
+                        indices(i, j) = heap[j].second;
+                    }
+                }
+            }
+        );
+    }
 
     const std::pair<MatType, IdxMatType> query(
-        const MatType& data, 
+        const MatType& data,
         std::size_t k) const {
-        
+
+        MatType distances;
+        IdxMatType indices;
+        query(data, k, distances, indices);
+        return std::make_pair(distances, indices);
+    }
+
+    /**
+     * approximate k nearest neighbors by best-bin-first search, Beis and
+     * Lowe 1997. Nodes are visited by increasing distance to their box
+     * from a priority queue, and the search stops once max_checks points
+     * have been checked, or once no box is closer than the k-th neighbor
+     * divided by 1 + epsilon. max_checks = num_samples and epsilon = 0
+     * give the exact neighbors.
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param max_checks number of points whose distance is computed
+     *      before stopping, the search goes on until k points are found
+     * @param epsilon double, the k-th distance is at most 1 + epsilon 
+     *      times the exact one if max_checks is not reached
+     * @param distances output distances sorted by increasing distance
+     * @param indices output indices of the neighbors in the tree data
+    */
+    void query_approx(const MatType& data,
+        std::size_t k,
+        std::size_t max_checks,
+        double epsilon,
+        MatType& distances,
+        IdxMatType& indices) const {
+
         std::size_t num_samples = data.rows();
-        MatType distances(num_samples, k);
-        IdxMatType indices(num_samples, k);
-
-        for(std::size_t i = 0; i < num_samples; ++i) {
-            std::vector<NNType> knn;
-            knn = query_single_data(data.row(i), k);
-            RowVecType dist(k);
-            IdxMatType index(1, k);
-            for (std::size_t j = 0; j < knn.size(); ++j) {
-                dist(0, j) = knn[j].first;
-                index(0, j) = knn[j].second;
-            }
-            distances.row(i) = dist;
-            indices.row(i) = index;
+        if (k == 0 || k > static_cast<std::size_t>(data_.cols())) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_samples of the tree, but got k = "
+                    << k << ", num_samples = " << data_.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (epsilon < 0.0) {
+            std::ostringstream err_msg;
+            err_msg << "epsilon must be non-negative, but got " << epsilon << std::endl;
+            throw std::invalid_argument(err_msg.str());
         }
+        resize_query_outputs(num_samples, k, distances, indices);
+
+        // a box is skipped if (1 + epsilon) times its distance is beyond
+        // the k-th neighbor, compared in reduced distances
+        DataType scale = to_reduced_distance(static_cast<DataType>(1.0 + epsilon));
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(data.cols());
+                std::vector<NNType> heap;
+                std::vector<NNType> queue;
+                heap.reserve(k);
+                auto key = [](Eigen::Index i) { return static_cast<long>(i); };
+                auto push = [&](DataType dist, std::size_t node) {
+                    if (heap.size() < k || dist * scale <= heap.front().first) {
+                        queue.emplace_back(dist, node);
+                        std::push_heap(queue.begin(), queue.end(), std::greater<NNType>());
+                    }
+                };
+                for (std::size_t i = first; i < last; ++i) {
+                    point = data.row(i).transpose();
+                    heap.clear();
+                    queue.assign(1, NNType(0, 0));
+                    std::size_t num_checks = 0;
+                    while (!queue.empty()) {
+                        NNType top = queue.front();
+                        if (heap.size() == k && 
+                            (num_checks >= max_checks || top.first * scale > heap.front().first)) {
+                            break;
+                        }
+                        std::pop_heap(queue.begin(), queue.end(), std::greater<NNType>());
+                        queue.pop_back();
+                        num_checks += descend_single_data(point, top.second, k, key, push, heap);
+                    }
+                    std::sort_heap(heap.begin(), heap.end());
+                    for (std::size_t j = 0; j < k; ++j) {
+                        distances(i, j) = to_distance(heap[j].first);
+                        indices(i, j) = heap[j].second;
+                    }
+                }
+            }
+        );
+    }
+
+    const std::pair<MatType, IdxMatType> query_approx(
+        const MatType& data,
+        std::size_t k,
+        std::size_t max_checks,
+        double epsilon = 0.0) const {
+
+        MatType distances;
+        IdxMatType indices;
+        query_approx(data, k, max_checks, epsilon, distances, indices);
         return std::make_pair(distances, indices);
     }
 
-    const std::vector<std::vector<NNType>> query_radius(
-        const MatType& data, 
+    /**
+     * k nearest neighbors graph of the points of the tree, computed by a
+     * dual-tree traversal of the tree against itself instead of one
+     * query per point. The query tree is split into subtrees traversed
+     * in parallel, their heaps and bounds are disjoint.
+     *
+     * @param k number of neighbors of a point, a point is not its own
+     *      neighbor, duplicates of a point are
+     * @param mutual bool, default false, keep the edge (i, j) only if j is
+     *      a neighbor of i and i a neighbor of j, the graph is then symmetric
+     * @return CSR matrix of shape (num_samples, num_samples), the row i
+     *      holds the distances from the point i to its neighbors, indexed
+     *      as the rows of the tree data
+    */
+    const SpMatType kneighbors_graph(std::size_t k, bool mutual = false) const {
+        std::size_t num_samples = data_.cols();
+        if (k == 0 || k >= num_samples) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k < num_samples of the tree, but got k = "
+                    << k << ", num_samples = " << num_samples << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+
+        DualTreeState state;
+        state.k = k;
+        state.heaps.resize(num_samples * k);
+        state.sizes.assign(num_samples, 0);
+        state.max_kth.assign(nodes_.size(), ConstType<DataType>::infinity());
+        state.min_kth.assign(nodes_.size(), ConstType<DataType>::infinity());
+        state.bounds.assign(nodes_.size(), ConstType<DataType>::infinity());
+
+        // split the query tree until there are enough subtrees for the threads
+        std::size_t num_jobs = parallel::get_num_jobs(n_jobs_);
+        std::vector<std::size_t> subtrees(1, 0);
+        while (num_jobs > 1 && subtrees.size() < 4 * num_jobs) {
+            std::vector<std::size_t> children;
+            for (std::size_t node : subtrees) {
+                if (nodes_[node].left < 0) {
+                    children.push_back(node);
+                }
+                else {
+                    children.push_back(nodes_[node].left);
+                    children.push_back(nodes_[node].right);
+                }
+            }
+            if (children.size() == subtrees.size()) {
+                break;
+            }
+            subtrees.swap(children);
+        }
+        parallel::parallel_for(0, subtrees.size(), 1, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t s = first; s < last; ++s) {
+                    dual_tree_node(subtrees[s], 0, state);
+                }
+            }
+        );
+
+        std::vector<Eigen::Triplet<DataType>> triplets;
+        triplets.reserve(num_samples * k);
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            NNType* heap = &state.heaps[i * k];
+            for (std::size_t j = 0; j < k; ++j) {
+                triplets.emplace_back(indices_(i), indices_(heap[j].second), to_distance(heap[j].first));
+            }
+        }
+        SpMatType graph(num_samples, num_samples);
+        graph.setFromTriplets(triplets.begin(), triplets.end());
+        if (!mutual) {
+            return graph;
+        }
+
+        // columns of a row are sorted, (i, j) is kept if the row j holds i
+        triplets.clear();
+        for (Eigen::Index i = 0; i < graph.outerSize(); ++i) {
+            for (typename SpMatType::InnerIterator it(graph, i); it; ++it) {
+                const typename SpMatType::StorageIndex* begin = graph.innerIndexPtr() + graph.outerIndexPtr()[it.col()];
+                const typename SpMatType::StorageIndex* end = graph.innerIndexPtr() + graph.outerIndexPtr()[it.col() + 1];
+                if (std::binary_search(begin, end, i)) {
+                    triplets.emplace_back(i, it.col(), it.value());
+                }
+            }
+        }
+        SpMatType mutual_graph(num_samples, num_samples);
+        mutual_graph.setFromTriplets(triplets.begin(), triplets.end());
+        return mutual_graph;
+    }
+
+    /**
+     * neighbors within a radius of a batch of points in CSR format, the
+     * neighbors of the query i are indices(offsets(i)) ... indices(offsets(i + 1) - 1),
+     * a query without neighbor has an empty range, so rows stay aligned.
+     * Queries are processed by blocks in parallel, see query_radius_csr.
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param radius distance within which neighbors are returned
+     * @param sort_results bool, default true, sort the neighbors of each query 
+     *      by increasing distance, false returns them in tree order
+     * @return a tuple of offsets of size num_samples + 1, indices and distances
+    */
+    const std::tuple<IdxVecType, IdxVecType, ColVecType> query_radius(
+        const MatType& data,
+        double radius,
+        bool sort_results = true) const {
+
+        DataType rradius = to_reduced_distance(static_cast<DataType>(radius));
+        return query_radius_csr<IdxVecType, ColVecType, NNType>(
+            data.rows(), KDTREE_QUERY_BLOCK_SIZE, n_jobs_, sort_results,
+            [&]() {
+                return [&, point = ColVecType(data.cols()), node_stack = std::vector<std::size_t>()]
+                    (std::size_t i, std::vector<NNType>& nns) mutable {
+                    point = data.row(i).transpose();
+                    query_radius_single_data(point, rradius, nns, node_stack);
+                };
+            }
+        );
+    }
+
+    /**
+     * number of neighbors within a radius of each point, no neighbor 
+     * is stored, nodes entirely inside the radius are not scanned
+     * @return counts of shape (num_samples,)
+    */
+    const IdxVecType query_radius_count(
+        const MatType& data,
         double radius) const {
-        
+
         std::size_t num_samples = data.rows();
-        std::vector<std::vector<NNType>> knn;
-        for(std::size_t i = 0; i < num_samples; ++i) {
-            std::vector<NNType> nn;
-            nn = query_radius_single_data(data.row(i), radius);
-            if (!nn.empty()) {
-                knn.emplace_back(nn);
+        DataType rradius = to_reduced_distance(static_cast<DataType>(radius));
+        IdxVecType counts(num_samples);
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                ColVecType point(data.cols());
+                std::vector<std::size_t> node_stack;
+                for (std::size_t i = first; i < last; ++i) {
+                    point = data.row(i).transpose();
+                    counts(i) = count_radius_single_data(point, rradius, node_stack);
+                }
             }
-        }
-        return knn;
+        );
+        return counts;
     }
 
+    /**
+     * read-only view of the nodes for algorithms walking the tree, such
+     * as neighbors::KernelDensity. Node 0 is the root, the points of a
+     * node are the columns [begin, end) of get_data(), in tree order,
+     * get_indices() maps them to the rows of the input data.
+     * @return begin, end, left and right child of a node, -1 for a leaf
+    */
+    std::tuple<std::size_t, std::size_t, long, long> get_node(std::size_t node) const {
+        const KDTreeNode& info = nodes_[node];
+        return std::make_tuple(info.begin, info.end, info.left, info.right);
+    }
+
+    std::size_t get_num_nodes() const {
+        return nodes_.size();
+    }
+
+    const MatType& get_data() const {
+        return data_;
+    }
+
+    const IdxVecType& get_indices() const {
+        return indices_;
+    }
+
+    /**
+     * lower and upper bounds of the distance between a point and the 
+     * points of a node, from the bounding box of the node
+    */
+    std::pair<DataType, DataType> get_node_distance_bounds(
+        const ColVecType& point, 
+        std::size_t node) const {
+        
+        return std::make_pair(to_distance(min_box_distance(point, node)), 
+            to_distance(max_box_distance(point, node)));
+    }
 
 };
 
 }
 }
-#endif /*CORE_TREE_KD_TREE_HPP*/
\ No newline at end of file
+#endif /*CORE_TREE_KD_TREE_HPP*/
@@ -0,0 +1,146 @@
+#ifndef CORE_TREE_QUERY_HPP
+#define CORE_TREE_QUERY_HPP
+#include "../../prereqs.hpp"
+#include "../parallel/parallel_for.hpp"
+
+namespace openml {
+namespace tree {
+
+/**
+ * visited marks of a search over num_points points. A new search only
+ * increments the mark, the marks are cleared when the counter overflows,
+ * so a list is allocated and zeroed once and reused by every search.
+*/
+struct VisitedList {
+    std::vector<std::uint32_t> marks;
+    std::uint32_t mark = 0;
+
+    // start a new search, the list grows to num_points if needed
+    void reset(std::size_t num_points) {
+        if (marks.size() < num_points) {
+            marks.resize(num_points, 0);
+        }
+        if (++mark == 0) {
+            std::fill(marks.begin(), marks.end(), 0);
+            mark = 1;
+        }
+    }
+
+    bool is_visited(std::size_t id) const {
+        return marks[id] == mark;
+    }
+
+    // mark id, return false if it was already visited
+    bool visit(std::size_t id) {
+        if (marks[id] == mark) {
+            return false;
+        }
+        marks[id] = mark;
+        return true;
+    }
+};
+
+/**
+ * visited list of the calling thread, shared by the searches of all
+ * the indexes run by this thread. parallel_for calls its body once per 
+ * chunk, a per-thread list avoids allocating num_points marks per chunk.
+ * A search must not keep it across a call that can run other tasks.
+*/
+inline VisitedList& get_visited_list() {
+    static thread_local VisitedList visited;
+    return visited;
+};
+
+/**
+ * resize the output matrices of a k nearest neighbors query, they
+ * are left untouched if their shape is already (num_samples, k)
+*/
+template<typename MatType, typename IdxMatType>
+void resize_query_outputs(std::size_t num_samples,
+    std::size_t k,
+    MatType& distances,
+    IdxMatType& indices) {
+
+    if (static_cast<std::size_t>(distances.rows()) != num_samples ||
+        static_cast<std::size_t>(distances.cols()) != k) {
+        distances.resize(num_samples, k);
+    }
+    if (static_cast<std::size_t>(indices.rows()) != num_samples ||
+        static_cast<std::size_t>(indices.cols()) != k) {
+        indices.resize(num_samples, k);
+    }
+};
+
+/**
+ * assemble the neighbors within a radius of a batch of points in CSR
+ * format, the neighbors of the query i are indices(offsets(i)) ...
+ * indices(offsets(i + 1) - 1). Queries are processed by blocks in
+ * parallel, the results of a block are gathered in a single buffer,
+ * then copied at their offsets once all the counts are known.
+ *
+ * @param num_samples number of queries
+ * @param block_size number of queries of a block
+ * @param n_jobs number of threads
+ * @param sort_results bool, sort the neighbors of each query by distance
+ * @param make_query callable returning the per-query callback
+ *      query(i, nns), which appends the (distance, index) pairs of the
+ *      neighbors of query i to nns. It is called once per range of
+ *      blocks, so that the callback can own its buffers.
+ * @return a tuple of offsets of size num_samples + 1, indices and distances
+*/
+template<typename IdxVecType,
+    typename ColVecType,
+    typename NNType,
+    typename Function>
+std::tuple<IdxVecType, IdxVecType, ColVecType> query_radius_csr(
+    std::size_t num_samples,
+    std::size_t block_size,
+    int n_jobs,
+    bool sort_results,
+    Function&& make_query) {
+
+    std::size_t num_blocks = (num_samples + block_size - 1) / block_size;
+    std::vector<std::vector<NNType>> block_nns(num_blocks);
+    IdxVecType offsets = IdxVecType::Zero(num_samples + 1);
+
+    parallel::parallel_for(0, num_blocks, 1, n_jobs,
+        [&](std::size_t first, std::size_t last) {
+            auto query = make_query();
+            for (std::size_t b = first; b < last; ++b) {
+                std::vector<NNType>& nns = block_nns[b];
+                std::size_t end = std::min(num_samples, (b + 1) * block_size);
+                for (std::size_t i = b * block_size; i < end; ++i) {
+                    std::size_t begin = nns.size();
+                    query(i, nns);
+                    if (sort_results) {
+                        std::sort(nns.begin() + begin, nns.end());
+                    }
+                    offsets(i + 1) = nns.size() - begin;
+                }
+            }
+        }
+    );
+
+    for (std::size_t i = 0; i < num_samples; ++i) {
+        offsets(i + 1) += offsets(i);
+    }
+    IdxVecType indices(offsets(num_samples));
+    ColVecType distances(offsets(num_samples));
+    parallel::parallel_for(0, num_blocks, 1, n_jobs,
+        [&](std::size_t first, std::size_t last) {
+            for (std::size_t b = first; b < last; ++b) {
+                Eigen::Index offset = offsets(b * block_size);
+                for (std::size_t j = 0; j < block_nns[b].size(); ++j) {
+                    distances(offset + j) = block_nns[b][j].first;
+                    indices(offset + j) = block_nns[b][j].second;
+                }
+                std::vector<NNType>().swap(block_nns[b]);
+            }
+        }
+    );
+    return std::make_tuple(offsets, indices, distances);
+};
+
+}
+}
+#endif /*CORE_TREE_QUERY_HPP*/
@@ -7,8 +7,45 @@ using namespace openml;
 namespace openml {
 namespace cluster {
 
+/**
+ * number of oversampling rounds of the kmeans|| initialization, 
+ * Bahmani et al. report that 5 rounds are enough in practice
+*/
+constexpr std::size_t KMEANS_PARALLEL_ROUNDS = 5;
+
+/**
+ * maximum number of samples of a leaf of the filtering kd-tree
+*/
+constexpr std::size_t KMEANS_FILTER_LEAF_SIZE = 16;
+
 /**
  * K-Means clustering.
+ * 
+ * @param init string, default "kmeans++", initialization of the centroids
+ *    "kmeans++": k sequential rounds of D^2 sampling with local trials
+ *    "kmeans||": a few rounds oversampling about 2k candidates in parallel,
+ *      reclustered with weighted kmeans++, faster for a large num_clusters
+ *    "random": num_clusters distinct random samples
+ * @param num_init size_t, default 10, number of runs with different 
+ *    initializations, the run with the lowest inertia is kept
+ * @param random_state long, default -1, seed of the centroid initialization,
+ *    a negative value means the generator is taken from the global seed
+ * @param n_jobs int, default 1, number of threads used to execute the runs,
+ *    to assign samples and to update centroids, -1 means using all cores
+ * @param algorithm string, default "lloyd", the k-means algorithm to use
+ *    "lloyd": computes all distances between samples and centroids 
+ *      at each iteration
+ *    "elkan": keeps an upper bound of the distance to the assigned centroid
+ *      and a lower bound per centroid, the triangle inequality skips most 
+ *      distance computations, it needs num_samples x num_clusters bounds
+ *    "hamerly": keeps a single lower bound per sample, less memory and 
+ *      cheaper bound updates than elkan, best for low dimensional data
+ *    "filtering": Kanungo et al. 2002 "An efficient k-means clustering 
+ *      algorithm: analysis and implementation", a kd-tree with the sum and 
+ *      the count of samples of each node is built once, centroids that can 
+ *      not be the closest to any point of a node are pruned, a node left 
+ *      with a single candidate is assigned at once, best for low 
+ *      dimensional data (num_features <= 8) with many samples
 */
 template<typename DataType>
 class KMeans {
@@ -23,167 +60,751 @@ private:
     std::size_t num_clusters_;
     std::size_t max_iter_;
     double tol_;
+    long random_state_;
+    int n_jobs_;
+    std::string algorithm_;
     
     MatType centroids_;
+    DataType inertia_;
+    std::size_t n_iter_;
+
+    /**
+     * node of the filtering tree, samples of a node are the contiguous 
+     * range [begin, end) of the reordered samples, a leaf has no child
+    */
+    struct FilterNode {
+        std::size_t begin;
+        std::size_t end;
+        long left;
+        long right;
+    };
+
+    /**
+     * kd-tree of the filtering algorithm, node statistics are stored 
+     * as columns: bounding box of the samples, their sum and count
+    */
+    struct FilterTree {
+        MatType Xt;
+        MatType lower;
+        MatType upper;
+        MatType sums;
+        VecType counts;
+        std::vector<FilterNode> nodes;
+    };
+
+    /**
+     * index of the first value of the cumulative sum 
+     * greater or equal to value, clamped to the last index
+    */
+    static std::size_t search_sorted(const VecType& cum_values, DataType value) {
+        auto lower = std::lower_bound(cum_values.begin(), cum_values.end(), value);
+        std::size_t index = static_cast<std::size_t>(
+            std::distance(cum_values.begin(), lower)
+        );
+        // numerical imprecision can result in an index out of range
+        return std::min<std::size_t>(index, cum_values.size() - 1);
+    }
 
     /**
-     * kmeans++ initialization of clusters
+     * kmeans++ initialization of clusters, the squared distances to the 
+     * centers and to the local trials are computed with pairwise distances
+     * using the cached squared norms of samples
+     *
+     * @param sample_weight optional weights of samples, a sample is drawn 
+     *    with a probability proportional to its weight times its squared 
+     *    distance to the closest center, used to recluster kmeans|| candidates
     */
-    const MatType kmeans_plusplus(const MatType& X) const {
+    const MatType kmeans_plusplus(const MatType& X, 
+        const VecType& x_squared_norms, 
+        random::Philox4x32& generator, 
+        const VecType* sample_weight = nullptr) const {
         std::size_t num_samples = X.rows(), num_features = X.cols();
         // copy from sklean tried, no specific results 
         // for other than mentioning in the conclusion
         std::size_t num_local_trials = 2 + 
             static_cast<std::size_t>(std::log(num_clusters_));
+        VecType weight = (sample_weight != nullptr) ? 
+            *sample_weight : VecType::Ones(num_samples);
         
         // generate randomly first index of center
-        auto center_index = random::randint<std::size_t>(1, 1, 0, num_samples - 1);
+        VecType cum_weight = math::cumsum<MatType, VecType>(weight, -1);
+        DataType rand_val = random::rand<MatType>(1, 1, 0.0, 1.0, generator).value();
+        std::size_t center_index = search_sorted(cum_weight, rand_val * cum_weight(num_samples - 1));
 
         MatType centers(num_clusters_, num_features);
-        centers.row(0) = X.row(center_index.value());
+        centers.row(0) = X.row(center_index);
 
         // compute the distance between all sample point and the first center point
-        MatType diff1 = X - common::repeat<MatType>(centers.row(0), num_samples, 0);
-        VecType closest_dist = math::row_norms<MatType, VecType>(diff1, true);
+        VecType center_norms = x_squared_norms.row(center_index);
+        VecType closest_dist = metric::pairwise_distances<MatType, VecType>(
+            X, centers.topRows(1), "sqeuclidean", n_jobs_, &x_squared_norms, &center_norms
+        );
 
         // compute the sume of distance, this param allows map a random value of 
         // domaine interval [0, 1] to a random intervall [0, current_pot]
-        auto tmp = math::sum<MatType>(closest_dist, -1);
-        DataType current_pot = tmp.value();
+        DataType current_pot = closest_dist.dot(weight);
         for (std::size_t c = 1; c < num_clusters_; ++c) {
             // Choose center candidates by sampling
-            VecType rand_vec = random::rand<MatType>(num_local_trials, 1);
-            DataType candidates_pot = ConstType<DataType>::max();
-            std::size_t best_candidates;
-            VecType closest_dist_to_candidates;
+            VecType rand_vec = random::rand<MatType>(num_local_trials, 1, 0.0, 1.0, generator);
+            // cumulative the closest distances
+            VecType cum_closest_dist = math::cumsum<MatType, VecType>(
+                closest_dist.cwiseProduct(weight), -1
+            );
 
+            IdxVecType candidate_indices(num_local_trials);
             for (std::size_t i = 0; i < num_local_trials; ++i) {
-                
-                DataType rand_val = rand_vec(i, 0) * current_pot;
-                // cumulative the closest distances
-                VecType cum_closest_dist = math::cumsum<MatType, VecType>(closest_dist, -1);
-
                 // find the first index of the related value 
                 // what is more than current random value
-                auto lower = std::lower_bound(
-                    cum_closest_dist.begin(), cum_closest_dist.end(), rand_val
-                );
-                std::size_t candidate_index = static_cast<std::size_t>(
-                    std::distance(cum_closest_dist.begin(), lower)
-                );
-                // numerical imprecision can result in a candidate_id out of range
-                if (candidate_index > closest_dist.size() - 1) {
-                    candidate_index = closest_dist.size() - 1;
-                }
-                //  Compute distances to center candidates
-                MatType diff2 = X - common::repeat<MatType>(X.row(candidate_index), num_samples, 0);
-                VecType dist_to_candidates = math::row_norms<MatType, VecType>(diff2, true);
-
-                // update closest distances squared and potential for each candidate
-                for (int i = 0; i < num_samples; ++i) {
-                    if (closest_dist(i, 0) < dist_to_candidates(i, 0)) {
-                        dist_to_candidates(i, 0) = closest_dist(i, 0);
-                    }
+                candidate_indices(i) = search_sorted(cum_closest_dist, rand_vec(i, 0) * current_pot);
+            }
+
+            // compute distances to all center candidates at once
+            MatType candidates = X(candidate_indices, Eigen::all);
+            VecType candidate_norms = x_squared_norms(candidate_indices);
+            MatType dist_to_candidates = metric::pairwise_distances<MatType, VecType>(
+                X, candidates, "sqeuclidean", n_jobs_, &x_squared_norms, &candidate_norms
+            );
+            // update closest distances squared and potential for each candidate
+            dist_to_candidates = dist_to_candidates.cwiseMin(
+                closest_dist.replicate(1, num_local_trials)
+            );
+            // Calculate the range values for all candidate prime roulette 
+            // selection mappings since minimum distance from each sample 
+            // to the prime was updated in the previous step, 
+            // choose which candidate is the best
+            VecType candidates_pot = dist_to_candidates.transpose() * weight;
+            Eigen::Index best_candidate;
+            current_pot = candidates_pot.minCoeff(&best_candidate);
+            closest_dist = dist_to_candidates.col(best_candidate);
+            centers.row(c) = candidates.row(best_candidate);
+        }
+        return centers;
+    }
+
+    /**
+     * scalable k-means++ initialization, Bahmani et al. 2012 "Scalable 
+     * k-means++". Each round draws every sample independently with a 
+     * probability proportional to its squared distance to the candidates, 
+     * about 2 x num_clusters samples per round. The candidates weighted by 
+     * the number of samples they are the closest to are then reclustered 
+     * with kmeans++. A round only needs one pass of pairwise distances 
+     * against the new candidates, instead of num_clusters sequential passes.
+    */
+    const MatType kmeans_parallel(const MatType& X, 
+        const VecType& x_squared_norms, 
+        random::Philox4x32& generator) const {
+        std::size_t num_samples = X.rows();
+        std::size_t num_threads = parallel::get_num_jobs(n_jobs_);
+        DataType oversampling = static_cast<DataType>(2 * num_clusters_);
+        
+        // first candidate uniformly
+        std::vector<Eigen::Index> candidate_indices;
+        candidate_indices.push_back(random::uniform_index(generator, num_samples));
+        VecType center_norms = x_squared_norms.row(candidate_indices[0]);
+        VecType closest_dist = metric::pairwise_distances<MatType, VecType>(
+            X, X.row(candidate_indices[0]), "sqeuclidean", n_jobs_, &x_squared_norms, &center_norms
+        );
+        IdxVecType closest_index = IdxVecType::Zero(num_samples);
+
+        for (std::size_t round = 0; round < KMEANS_PARALLEL_ROUNDS; ++round) {
+            DataType current_pot = closest_dist.sum();
+            if (current_pot <= 0) {
+                break;
+            }
+            // one uniform value per sample, the draw does not depend on the 
+            // number of threads
+            VecType rand_vec = random::rand<MatType>(num_samples, 1, 0.0, 1.0, generator, num_threads);
+            std::vector<Eigen::Index> new_indices;
+            for (std::size_t i = 0; i < num_samples; ++i) {
+                if (rand_vec(i) * current_pot < oversampling * closest_dist(i)) {
+                    new_indices.push_back(i);
                 }
-                // Calculate the range values for all candidate prime roulette 
-                // selection mappings since minimum distance from each sample 
-                // to the prime was updated in the previous step
-                DataType current_candidates_pot = dist_to_candidates.array().sum();
-                // choose which candidate is the best
-                if (current_candidates_pot < candidates_pot) {
-                    candidates_pot = current_candidates_pot;
-                    best_candidates = candidate_index;
-                    closest_dist_to_candidates = dist_to_candidates;
+            }
+            if (new_indices.empty()) {
+                continue;
+            }
+
+            // distances to the new candidates only
+            MatType new_candidates = X(new_indices, Eigen::all);
+            VecType new_norms = x_squared_norms(new_indices);
+            IdxVecType labels;
+            VecType min_dist;
+            std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+                X, new_candidates, "sqeuclidean", n_jobs_, &x_squared_norms, &new_norms
+            );
+            std::size_t offset = candidate_indices.size();
+            for (std::size_t i = 0; i < num_samples; ++i) {
+                if (min_dist(i) < closest_dist(i)) {
+                    closest_dist(i) = min_dist(i);
+                    closest_index(i) = offset + labels(i);
                 }
             }
-            current_pot = candidates_pot;
-            closest_dist = closest_dist_to_candidates;
-            centers.row(c) = X.row(best_candidates);
+            candidate_indices.insert(candidate_indices.end(), new_indices.begin(), new_indices.end());
         }
-        return centers;
+
+        // too few candidates, e.g. many duplicated samples
+        if (candidate_indices.size() < num_clusters_) {
+            return kmeans_plusplus(X, x_squared_norms, generator);
+        }
+
+        // weight of a candidate is the number of samples closest to it
+        VecType weight = VecType::Zero(candidate_indices.size());
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            weight(closest_index(i)) += 1;
+        }
+        MatType candidates = X(candidate_indices, Eigen::all);
+        VecType candidate_norms = x_squared_norms(candidate_indices);
+        return kmeans_plusplus(candidates, candidate_norms, generator, &weight);
     }
 
 protected:
-    void init_centroid(const MatType& X, 
-        const VecType& x_squared_norms) {
+    /**
+     * the methods of a run only read the members, 
+     * so that several runs can be executed concurrently
+    */
+    const MatType init_centroid(const MatType& X, 
+        const VecType& x_squared_norms, 
+        random::Philox4x32& generator) const {
         
-        std::size_t num_samples = X.rows(), num_features = X.cols(); 
-        centroids_.resize(num_clusters_, num_features);
-
+        std::size_t num_samples = X.rows(); 
+        MatType centroids;
         if (init_ == "random") {
-            IdxVecType index = random::permutation<IdxVecType>(num_samples);
+            IdxVecType index = random::permutation<IdxVecType>(num_samples, generator);
             IdxVecType selected_index = index.topRows(num_clusters_);
-            centroids_ = X(selected_index, Eigen::all);
+            centroids = X(selected_index, Eigen::all);
         } 
-        else if (init_ == "kmeans++") {
-            centroids_ = kmeans_plusplus(X);
+        else if (init_ == "kmeans||") {
+            centroids = kmeans_parallel(X, x_squared_norms, generator);
         }
+        else {
+            centroids = kmeans_plusplus(X, x_squared_norms, generator);
+        }
+        return centroids;
     }
     
 
+    /**
+     * move the centroids to the mean of their assigned samples, 
+     * a centroid without sample is unchanged. Samples are split into 
+     * one contiguous chunk per thread, each chunk accumulates into its 
+     * own sum and count buffers, buffers are merged in chunk order.
+     * @return the shift of each centroid
+    */
+    VecType update_centroids(const MatType& X, 
+        const IdxVecType& labels, 
+        MatType& centroids) const {
+        
+        std::size_t num_samples = X.rows(), num_features = X.cols();
+        std::size_t num_chunks = std::min<std::size_t>(
+            parallel::get_num_jobs(n_jobs_), std::max<std::size_t>(num_samples, 1)
+        );
+        std::size_t chunk_size = (num_samples + num_chunks - 1) / num_chunks;
+        std::vector<MatType> sums(num_chunks, MatType::Zero(num_clusters_, num_features));
+        std::vector<VecType> counts(num_chunks, VecType::Zero(num_clusters_));
+        parallel::parallel_for(0, num_chunks, 1, n_jobs_, 
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t k = first; k < last; ++k) {
+                    std::size_t end = std::min(num_samples, (k + 1) * chunk_size);
+                    for (std::size_t i = k * chunk_size; i < end; ++i) {
+                        sums[k].row(labels(i)) += X.row(i);
+                        counts[k](labels(i)) += 1;
+                    }
+                }
+            }
+        );
+        for (std::size_t k = 1; k < num_chunks; ++k) {
+            sums[0] += sums[k];
+            counts[0] += counts[k];
+        }
+
+        VecType shift = VecType::Zero(num_clusters_);
+        for (std::size_t c = 0; c < num_clusters_; ++c) {
+            if (counts[0](c) > 0) {
+                sums[0].row(c) /= counts[0](c);
+                shift(c) = (sums[0].row(c) - centroids.row(c)).norm();
+                centroids.row(c) = sums[0].row(c);
+            }
+        }
+        return shift;
+    }
+
+    /**
+     * distances between centroids, and half the distance of 
+     * each centroid to its closest other centroid
+    */
+    void compute_center_distances(const MatType& Ct, 
+        MatType& center_dist, 
+        VecType& half_min_dist) const {
+
+        center_dist.resize(num_clusters_, num_clusters_);
+        half_min_dist.resize(num_clusters_);
+        for (std::size_t c1 = 0; c1 < num_clusters_; ++c1) {
+            center_dist(c1, c1) = 0;
+            for (std::size_t c2 = 0; c2 < c1; ++c2) {
+                DataType dist = (Ct.col(c1) - Ct.col(c2)).norm();
+                center_dist(c1, c2) = dist;
+                center_dist(c2, c1) = dist;
+            }
+        }
+        for (std::size_t c = 0; c < num_clusters_; ++c) {
+            DataType min_dist = ConstType<DataType>::infinity();
+            for (std::size_t c2 = 0; c2 < num_clusters_; ++c2) {
+                if (c2 != c) {
+                    min_dist = std::min(min_dist, center_dist(c, c2));
+                }
+            }
+            half_min_dist(c) = min_dist / 2;
+        }
+    }
+
     /**
      * k-means lloyd method
+     * @return the number of iterations
     */
-    void kmeans_lloyd(const MatType& X) {
+    std::size_t kmeans_lloyd(const MatType& X, 
+        const VecType& x_squared_norms, 
+        MatType& centroids) const {
 
-        // bool converged = false;
-        std::size_t num_samples = X.rows(), num_features = X.cols(); 
         for (std::size_t iter = 0; iter < max_iter_; ++iter) {
-            // define the cluster
-            std::map<std::size_t, std::vector<std::size_t>> clusters;
-            for (std::size_t i = 0; i < num_samples; ++i) {
-                std::size_t min_dist_index = 0;
-                double min_dist = ConstType<double>::infinity();
-                // compute the min distance between sample and centroid
-                for (std::size_t j = 0; j < num_clusters_; ++j) {
-                    MatType tmp;
-                    tmp = X.row(i).array() - centroids_.row(j).array();
-                    double dist = static_cast<double>(tmp.norm());
-                    if (dist < min_dist) {
-                        min_dist = dist;
-                        min_dist_index = j;
+            // assign each sample to the closest centroid
+            IdxVecType labels;
+            VecType min_dist;
+            std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+                X, centroids, "sqeuclidean", n_jobs_, &x_squared_norms
+            );
+            // move the centers 
+            VecType shift = update_centroids(X, labels, centroids);
+            // convergen condition
+            if (shift.sum() < tol_) {
+                return iter + 1;
+            }
+        }
+        return max_iter_;
+    }
+
+    /**
+     * k-means elkan method, Elkan 2003 "Using the triangle inequality 
+     * to accelerate k-means". For each sample, upper bounds the distance 
+     * to its centroid, lower(c, i) bounds the distance to centroid c. 
+     * The distance to c is only computed when neither the lower bound 
+     * nor half the distance between centroids can rule c out.
+    */
+    std::size_t kmeans_elkan(const MatType& X, MatType& centroids) const {
+        std::size_t num_samples = X.rows();
+        // samples and centroids as columns, features of a sample are contiguous
+        MatType Xt = X.transpose();
+        MatType Ct = centroids.transpose();
+
+        IdxVecType labels(num_samples);
+        VecType upper(num_samples);
+        MatType lower(num_clusters_, num_samples);
+        parallel::parallel_for(0, num_samples, 0, n_jobs_, 
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i) {
+                    for (std::size_t c = 0; c < num_clusters_; ++c) {
+                        lower(c, i) = (Xt.col(i) - Ct.col(c)).norm();
                     }
+                    upper(i) = lower.col(i).minCoeff(&labels(i));
                 }
-                clusters[min_dist_index].push_back(i);
             }
-            // move the centers 
-            double eps = 0.0; 
-            for (auto c : clusters) {
-                MatType cluster = X(c.second, Eigen::all);
-                auto mean_c = math::mean<MatType>(cluster, 0);
-                auto diff = mean_c - centroids_.row(c.first);
-                
-                eps += static_cast<double>(diff.norm());
-                centroids_.row(c.first) = mean_c.transpose();
+        );
+
+        MatType center_dist;
+        VecType half_min_dist;
+        for (std::size_t iter = 0; iter < max_iter_; ++iter) {
+            compute_center_distances(Ct, center_dist, half_min_dist);
+            parallel::parallel_for(0, num_samples, 0, n_jobs_, 
+                [&](std::size_t first, std::size_t last) {
+                    for (std::size_t i = first; i < last; ++i) {
+                        std::size_t label = static_cast<std::size_t>(labels(i));
+                        if (upper(i) <= half_min_dist(label)) {
+                            continue;
+                        }
+                        bool tight = false;
+                        for (std::size_t c = 0; c < num_clusters_; ++c) {
+                            if (c == label || upper(i) <= lower(c, i) || 
+                                upper(i) <= center_dist(label, c) / 2) {
+                                continue;
+                            }
+                            // tighten the upper bound once
+                            if (!tight) {
+                                upper(i) = (Xt.col(i) - Ct.col(label)).norm();
+                                lower(label, i) = upper(i);
+                                tight = true;
+                                if (upper(i) <= lower(c, i) || 
+                                    upper(i) <= center_dist(label, c) / 2) {
+                                    continue;
+                                }
+                            }
+                            DataType dist = (Xt.col(i) - Ct.col(c)).norm();
+                            lower(c, i) = dist;
+                            if (dist < upper(i)) {
+                                label = c;
+                                upper(i) = dist;
+                            }
+                        }
+                        labels(i) = label;
+                    }
+                }
+            );
+
+            VecType shift = update_centroids(X, labels, centroids);
+            Ct = centroids.transpose();
+            // centroids moved by shift, bounds are moved accordingly
+            lower = (lower.colwise() - shift).cwiseMax(static_cast<DataType>(0));
+            for (std::size_t i = 0; i < num_samples; ++i) {
+                upper(i) += shift(labels(i));
             }
-            // convergen condition
-            if (eps < tol_) {
-                break;
+            if (shift.sum() < tol_) {
+                return iter + 1;
             }
         }
+        return max_iter_;
     }
 
     /**
-     * predict label
+     * k-means hamerly method, Hamerly 2010 "Making k-means even faster".
+     * Same principle as elkan with a single lower bound per sample, 
+     * the distance to the second closest centroid.
     */
-    const VecType predict_label(const MatType& X) const{
+    std::size_t kmeans_hamerly(const MatType& X, MatType& centroids) const {
         std::size_t num_samples = X.rows();
-        VecType y_pred(num_samples);
-        for (std::size_t i = 0; i < num_samples; ++i) {
-            std::size_t min_dist_index = 0;
-            double min_dist = ConstType<double>::infinity();
+        MatType Xt = X.transpose();
+        MatType Ct = centroids.transpose();
+
+        IdxVecType labels(num_samples);
+        VecType upper(num_samples), lower(num_samples);
 
-            for (std::size_t j = 0; j < num_clusters_; ++j) {
-                MatType diff;
-                diff = X.row(i).array() - centroids_.row(j).array();
-                double dist = static_cast<double>(diff.norm());
+        // find the closest and the second closest centroids of sample i
+        auto assign = [&](std::size_t i) {
+            DataType min_dist = ConstType<DataType>::infinity();
+            DataType second_dist = ConstType<DataType>::infinity();
+            Eigen::Index label = 0;
+            for (std::size_t c = 0; c < num_clusters_; ++c) {
+                DataType dist = (Xt.col(i) - Ct.col(c)).norm();
                 if (dist < min_dist) {
+                    second_dist = min_dist;
                     min_dist = dist;
-                    min_dist_index = j;
+                    label = c;
+                }
+                else if (dist < second_dist) {
+                    second_dist = dist;
+                }
+            }
+            labels(i) = label;
+            upper(i) = min_dist;
+            lower(i) = second_dist;
+        };
+
+        parallel::parallel_for(0, num_samples, 0, n_jobs_, 
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; ++i) {
+                    assign(i);
+                }
+            }
+        );
+
+        MatType center_dist;
+        VecType half_min_dist;
+        for (std::size_t iter = 0; iter < max_iter_; ++iter) {
+            compute_center_distances(Ct, center_dist, half_min_dist);
+            parallel::parallel_for(0, num_samples, 0, n_jobs_, 
+                [&](std::size_t first, std::size_t last) {
+                    for (std::size_t i = first; i < last; ++i) {
+                        DataType bound = std::max(half_min_dist(labels(i)), lower(i));
+                        if (upper(i) <= bound) {
+                            continue;
+                        }
+                        upper(i) = (Xt.col(i) - Ct.col(labels(i))).norm();
+                        if (upper(i) <= bound) {
+                            continue;
+                        }
+                        assign(i);
+                    }
                 }
+            );
+
+            VecType shift = update_centroids(X, labels, centroids);
+            Ct = centroids.transpose();
+            // the lower bound decreases by the largest shift 
+            // among the centroids other than the assigned one
+            Eigen::Index max_index;
+            DataType max_shift = shift.maxCoeff(&max_index);
+            DataType second_shift = 0;
+            for (std::size_t c = 0; c < num_clusters_; ++c) {
+                if (c != static_cast<std::size_t>(max_index)) {
+                    second_shift = std::max(second_shift, shift(c));
+                }
+            }
+            for (std::size_t i = 0; i < num_samples; ++i) {
+                upper(i) += shift(labels(i));
+                lower(i) -= (labels(i) == max_index) ? second_shift : max_shift;
+            }
+            if (shift.sum() < tol_) {
+                return iter + 1;
+            }
+        }
+        return max_iter_;
+    }
+
+    /**
+     * build the node of the filtering tree over order[begin, end), the 
+     * node is split at the median of the widest dimension of its box
+     * @return the index of the node
+    */
+    long build_filter_node(const MatType& X, 
+        std::vector<Eigen::Index>& order, 
+        std::size_t begin, 
+        std::size_t end, 
+        FilterTree& tree) const {
+
+        std::size_t num_features = X.cols();
+        long index = tree.nodes.size();
+        tree.nodes.push_back(FilterNode{begin, end, -1, -1});
+
+        VecType lower = VecType::Constant(num_features, ConstType<DataType>::infinity());
+        VecType upper = VecType::Constant(num_features, -ConstType<DataType>::infinity());
+        for (std::size_t i = begin; i < end; ++i) {
+            lower = lower.cwiseMin(X.row(order[i]).transpose());
+            upper = upper.cwiseMax(X.row(order[i]).transpose());
+        }
+        tree.lower.col(index) = lower;
+        tree.upper.col(index) = upper;
+        tree.counts(index) = static_cast<DataType>(end - begin);
+
+        if (end - begin <= KMEANS_FILTER_LEAF_SIZE) {
+            tree.sums.col(index).setZero();
+            for (std::size_t i = begin; i < end; ++i) {
+                tree.sums.col(index) += X.row(order[i]).transpose();
             }
-            y_pred(i) = min_dist_index;
+            return index;
         }
+
+        Eigen::Index axis;
+        (upper - lower).maxCoeff(&axis);
+        std::size_t mid = begin + (end - begin) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, 
+            [&X, axis](Eigen::Index i, Eigen::Index j) {
+                return X(i, axis) < X(j, axis);
+            }
+        );
+        long left = build_filter_node(X, order, begin, mid, tree);
+        long right = build_filter_node(X, order, mid, end, tree);
+        tree.nodes[index].left = left;
+        tree.nodes[index].right = right;
+        tree.sums.col(index) = tree.sums.col(left) + tree.sums.col(right);
+        return index;
+    }
+
+    void build_filter_tree(const MatType& X, FilterTree& tree) const {
+        std::size_t num_samples = X.rows(), num_features = X.cols();
+        // a binary tree with leaves of at least half the leaf size
+        std::size_t max_nodes = 4 * (num_samples / KMEANS_FILTER_LEAF_SIZE + 1);
+        tree.lower.resize(num_features, max_nodes);
+        tree.upper.resize(num_features, max_nodes);
+        tree.sums.resize(num_features, max_nodes);
+        tree.counts.resize(max_nodes);
+        tree.nodes.clear();
+        tree.nodes.reserve(max_nodes);
+
+        std::vector<Eigen::Index> order(num_samples);
+        std::iota(order.begin(), order.end(), 0);
+        build_filter_node(X, order, 0, num_samples, tree);
+
+        std::size_t num_nodes = tree.nodes.size();
+        tree.lower.conservativeResize(Eigen::NoChange, num_nodes);
+        tree.upper.conservativeResize(Eigen::NoChange, num_nodes);
+        tree.sums.conservativeResize(Eigen::NoChange, num_nodes);
+        tree.counts.conservativeResize(num_nodes);
+        // samples in tree order, a leaf is a contiguous block of columns
+        tree.Xt = X(order, Eigen::all).transpose();
+    }
+
+    /**
+     * keep the candidates that may be the closest centroid of a point of 
+     * the node. z_best is the candidate closest to the center of the box, 
+     * z is pruned if it is farther than z_best from the vertex of the box 
+     * the furthest in the direction z - z_best, so from the whole box
+    */
+    std::vector<Eigen::Index> prune_candidates(const FilterTree& tree, 
+        std::size_t node, 
+        const std::vector<Eigen::Index>& candidates, 
+        const MatType& Ct) const {
+
+        VecType middle = (tree.lower.col(node) + tree.upper.col(node)) / 2;
+        Eigen::Index z_best = candidates[0];
+        DataType best_dist = ConstType<DataType>::infinity();
+        for (Eigen::Index z : candidates) {
+            DataType dist = (Ct.col(z) - middle).squaredNorm();
+            if (dist < best_dist) {
+                best_dist = dist;
+                z_best = z;
+            }
+        }
+
+        std::vector<Eigen::Index> pruned;
+        pruned.reserve(candidates.size());
+        for (Eigen::Index z : candidates) {
+            if (z == z_best) {
+                pruned.push_back(z);
+                continue;
+            }
+            VecType vertex = ((Ct.col(z) - Ct.col(z_best)).array() > 0).select(
+                tree.upper.col(node), tree.lower.col(node)
+            );
+            if ((Ct.col(z) - vertex).squaredNorm() < (Ct.col(z_best) - vertex).squaredNorm()) {
+                pruned.push_back(z);
+            }
+        }
+        return pruned;
+    }
+
+    /**
+     * accumulate the samples of the node into the sums and counts 
+     * of their closest centroids among the candidates
+    */
+    void filter_node(const FilterTree& tree, 
+        std::size_t node, 
+        const std::vector<Eigen::Index>& candidates, 
+        const MatType& Ct, 
+        MatType& sums, 
+        VecType& counts) const {
+
+        std::vector<Eigen::Index> pruned = prune_candidates(tree, node, candidates, Ct);
+        const FilterNode& info = tree.nodes[node];
+        // a single candidate owns all the samples of the node
+        if (pruned.size() == 1) {
+            sums.col(pruned[0]) += tree.sums.col(node);
+            counts(pruned[0]) += tree.counts(node);
+            return ;
+        }
+        if (info.left < 0) {
+            for (std::size_t i = info.begin; i < info.end; ++i) {
+                Eigen::Index label = pruned[0];
+                DataType min_dist = ConstType<DataType>::infinity();
+                for (Eigen::Index z : pruned) {
+                    DataType dist = (tree.Xt.col(i) - Ct.col(z)).squaredNorm();
+                    if (dist < min_dist) {
+                        min_dist = dist;
+                        label = z;
+                    }
+                }
+                sums.col(label) += tree.Xt.col(i);
+                counts(label) += 1;
+            }
+            return ;
+        }
+        filter_node(tree, info.left, pruned, Ct, sums, counts);
+        filter_node(tree, info.right, pruned, Ct, sums, counts);
+    }
+
+    /**
+     * k-means filtering method, the tree is shared by all runs. The top 
+     * of the tree is filtered until there are enough subtrees to balance 
+     * the threads, subtrees are then filtered in parallel, each thread 
+     * accumulates into its own sum and count buffers
+     * @return the number of iterations
+    */
+    std::size_t kmeans_filtering(const FilterTree& tree, MatType& centroids) const {
+        std::size_t num_features = tree.Xt.rows();
+        std::size_t num_threads = parallel::get_num_jobs(n_jobs_);
+        using WorkType = std::pair<std::size_t, std::vector<Eigen::Index>>;
+
+        std::vector<Eigen::Index> all_candidates(num_clusters_);
+        std::iota(all_candidates.begin(), all_candidates.end(), 0);
+        for (std::size_t iter = 0; iter < max_iter_; ++iter) {
+            MatType Ct = centroids.transpose();
+
+            // split the top of the tree into subtrees with their candidates
+            std::vector<WorkType> works{WorkType(0, all_candidates)};
+            while (num_threads > 1 && works.size() < 8 * num_threads) {
+                std::vector<WorkType> next_works;
+                bool split = false;
+                for (const WorkType& work : works) {
+                    const FilterNode& info = tree.nodes[work.first];
+                    std::vector<Eigen::Index> pruned = prune_candidates(tree, work.first, work.second, Ct);
+                    if (info.left < 0 || pruned.size() == 1) {
+                        next_works.emplace_back(work.first, std::move(pruned));
+                    }
+                    else {
+                        next_works.emplace_back(info.left, pruned);
+                        next_works.emplace_back(info.right, std::move(pruned));
+                        split = true;
+                    }
+                }
+                works.swap(next_works);
+                if (!split) {
+                    break;
+                }
+            }
+
+            std::size_t num_works = works.size();
+            std::size_t num_chunks = std::min(num_threads, num_works);
+            std::size_t chunk_size = (num_works + num_chunks - 1) / num_chunks;
+            std::vector<MatType> sums(num_chunks, MatType::Zero(num_features, num_clusters_));
+            std::vector<VecType> counts(num_chunks, VecType::Zero(num_clusters_));
+            parallel::parallel_for(0, num_chunks, 1, n_jobs_, 
+                [&](std::size_t first, std::size_t last) {
+                    for (std::size_t k = first; k < last; ++k) {
+                        std::size_t end = std::min(num_works, (k + 1) * chunk_size);
+                        for (std::size_t w = k * chunk_size; w < end; ++w) {
+                            filter_node(tree, works[w].first, works[w].second, Ct, sums[k], counts[k]);
+                        }
+                    }
+                }
+            );
+            for (std::size_t k = 1; k < num_chunks; ++k) {
+                sums[0] += sums[k];
+                counts[0] += counts[k];
+            }
+
+            VecType shift = VecType::Zero(num_clusters_);
+            for (std::size_t c = 0; c < num_clusters_; ++c) {
+                if (counts[0](c) > 0) {
+                    VecType centroid = sums[0].col(c) / counts[0](c);
+                    shift(c) = (centroid - Ct.col(c)).norm();
+                    centroids.row(c) = centroid.transpose();
+                }
+            }
+            if (shift.sum() < tol_) {
+                return iter + 1;
+            }
+        }
+        return max_iter_;
+    }
+
+    /**
+     * one k-means run from the given initial centroids
+     * @param tree the filtering tree, only used by the filtering method
+     * @return the number of iterations
+    */
+    std::size_t kmeans_single(const MatType& X, 
+        const VecType& x_squared_norms, 
+        const FilterTree& tree, 
+        MatType& centroids) const {
+        // bounds need at least 2 centroids
+        if (algorithm_ == "lloyd" || num_clusters_ < 2) {
+            return kmeans_lloyd(X, x_squared_norms, centroids);
+        }
+        else if (algorithm_ == "elkan") {
+            return kmeans_elkan(X, centroids);
+        }
+        else if (algorithm_ == "filtering") {
+            return kmeans_filtering(tree, centroids);
+        }
+        return kmeans_hamerly(X, centroids);
+    }
+
+    /**
+     * predict label
+    */
+    const VecType predict_label(const MatType& X) const{
+        IdxVecType labels;
+        VecType min_dist;
+        std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+            X, centroids_, "sqeuclidean", n_jobs_
+        );
+        VecType y_pred = labels.template cast<DataType>();
         return y_pred;
     }
 
@@ -192,25 +813,88 @@ public:
         num_init_(10),
         num_clusters_(3), 
         max_iter_(300), 
-        tol_(1e-4) {};
+        tol_(1e-4), 
+        random_state_(-1), 
+        n_jobs_(1), 
+        algorithm_("lloyd"), 
+        inertia_(0), 
+        n_iter_(0) {};
 
     KMeans(std::string init,
         std::size_t num_init,
         std::size_t num_clusters,
         std::size_t max_iter, 
-        double tol): init_(init), 
+        double tol, 
+        long random_state = -1, 
+        int n_jobs = 1, 
+        std::string algorithm = "lloyd"): init_(init), 
             num_init_(num_init),
             num_clusters_(num_clusters), 
             max_iter_(max_iter), 
-            tol_(tol) {};
+            tol_(tol), 
+            random_state_(random_state), 
+            n_jobs_(n_jobs), 
+            algorithm_(algorithm), 
+            inertia_(0), 
+            n_iter_(0) {};
 
     ~KMeans() {};
     /**
-     * fit dataset to compute k-means clustering
+     * fit dataset to compute k-means clustering, num_init runs are executed 
+     * concurrently from different initializations, each run draws from its 
+     * own substream of the generator, the run with the lowest inertia is kept
     */
     void fit(const MatType& X) {
-        init_centroid(X, VecType());
-        kmeans_lloyd(X);
+        if (algorithm_ != "lloyd" && algorithm_ != "elkan" && 
+            algorithm_ != "hamerly" && algorithm_ != "filtering") {
+            std::ostringstream err_msg;
+            err_msg << "algorithm must be 'lloyd', 'elkan', 'hamerly' or 'filtering', "
+                    << "but got: " << algorithm_ << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (init_ != "kmeans++" && init_ != "kmeans||" && init_ != "random") {
+            std::ostringstream err_msg;
+            err_msg << "init must be 'kmeans++', 'kmeans||' or 'random', "
+                    << "but got: " << init_ << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (num_init_ == 0) {
+            throw std::invalid_argument("num_init must be positive.");
+        }
+        random::Philox4x32 generator = random::make_generator(random_state_);
+        VecType x_squared_norms = X.rowwise().squaredNorm();
+        // the tree only depends on the data, it is built once for all runs
+        FilterTree tree;
+        if (algorithm_ == "filtering" && num_clusters_ >= 2) {
+            build_filter_tree(X, tree);
+        }
+
+        std::vector<MatType> run_centroids(num_init_);
+        std::vector<std::size_t> run_iters(num_init_);
+        VecType run_inertia(num_init_);
+        parallel::parallel_for(0, num_init_, 1, n_jobs_, 
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t r = first; r < last; ++r) {
+                    random::Philox4x32 run_generator = generator.substream(r);
+                    MatType centroids = init_centroid(X, x_squared_norms, run_generator);
+                    run_iters[r] = kmeans_single(X, x_squared_norms, tree, centroids);
+                    // inertia of the final centroids
+                    IdxVecType labels;
+                    VecType min_dist;
+                    std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+                        X, centroids, "sqeuclidean", n_jobs_, &x_squared_norms
+                    );
+                    run_inertia(r) = min_dist.sum();
+                    run_centroids[r] = std::move(centroids);
+                }
+            }
+        );
+        // ties are resolved by the first run, the result does not
+        // depend on the number of threads
+        Eigen::Index best_run;
+        inertia_ = run_inertia.minCoeff(&best_run);
+        centroids_ = run_centroids[best_run];
+        n_iter_ = run_iters[best_run];
     }
 
     /**
@@ -224,6 +908,27 @@ public:
 
     }   
 
+    /**
+     * get the centroids of shape [num_clusters, num_features]
+    */
+    const MatType get_centroids() const {
+        return centroids_;
+    }
+
+    /**
+     * get the sum of squared distances of samples to their closest centroid
+    */
+    const DataType get_inertia() const {
+        return inertia_;
+    }
+
+    /**
+     * get the number of iterations of the best run
+    */
+    std::size_t get_num_iters() const {
+        return n_iter_;
+    }
+
 };
 
 } // cluster_model
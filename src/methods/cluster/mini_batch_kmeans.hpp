@@ -0,0 +1,351 @@
+#ifndef METHODS_CLUSTER_MINI_BATCH_KMEANS_HPP
+#define METHODS_CLUSTER_MINI_BATCH_KMEANS_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+#include "./kmeans.hpp"
+using namespace openml;
+
+namespace openml {
+namespace cluster {
+
+/**
+ * Mini-batch K-Means clustering, Sculley 2010 "Web-scale k-means clustering".
+ * Each step assigns a mini-batch to the closest centroids and moves every
+ * centroid towards the mean of its samples with a per-center learning rate
+ * 1 / count, count being the number of samples the centroid has seen so far.
+ * Only one batch is resident in memory, so the model can be fitted on a
+ * data::DataSource or updated incrementally with partial_fit.
+ *
+ * @param init string, default "kmeans++", initialization of the centroids
+ *    on the first samples, "kmeans++" or "random"
+ * @param batch_size size_t, default 1024, number of samples of a mini-batch
+ * @param max_iter size_t, default 100, maximum number of epochs over the data
+ * @param tol double, default 0.0, stop when the sum of the centroid shifts
+ *    of a step is less than tol, 0 disables this criterion
+ * @param max_no_improvement size_t, default 10, stop when the smoothed
+ *    inertia of the batches does not decrease for max_no_improvement
+ *    consecutive steps, 0 disables this criterion
+ * @param reassignment_ratio double, default 0.01, centroids whose count is
+ *    less than reassignment_ratio x the largest count are moved to random
+ *    samples of the current batch, 0 disables the reassignment
+ * @param random_state long, default -1, seed of the initialization, of the
+ *    batch sampling and of the reassignment, a negative value means the
+ *    generator is taken from the global seed
+ * @param n_jobs int, default 1, number of threads used to assign samples
+ *    to centroids, -1 means using all cores
+*/
+template<typename DataType>
+class MiniBatchKMeans {
+private:
+    // define matrix and vector Eigen type
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+
+    std::string init_;
+    std::size_t num_clusters_;
+    std::size_t batch_size_;
+    std::size_t max_iter_;
+    double tol_;
+    std::size_t max_no_improvement_;
+    double reassignment_ratio_;
+    long random_state_;
+    int n_jobs_;
+
+    MatType centroids_;
+    VecType counts_;
+    bool initialized_;
+    std::size_t num_steps_;
+    std::size_t num_since_reassign_;
+    random::Philox4x32 generator_;
+
+    /**
+     * initialize the centroids with the k-means initialization
+     * of the given samples, counts start from zero
+    */
+    void init_centroids(const MatType& X) {
+        if (static_cast<std::size_t>(X.rows()) < num_clusters_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected at least num_clusters = " << num_clusters_
+                    << " samples to initialize the centroids, but got "
+                    << X.rows() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        // KMeans with no iteration only runs the initialization
+        long seed = static_cast<long>(generator_.next_uint64() >> 1);
+        KMeans<DataType> kmeans(init_, 1, num_clusters_, 0, tol_, seed, n_jobs_);
+        kmeans.fit(X);
+        centroids_ = kmeans.get_centroids();
+        counts_ = VecType::Zero(num_clusters_);
+        num_steps_ = 0;
+        num_since_reassign_ = 0;
+        initialized_ = true;
+    }
+
+    /**
+     * move the centroids with too few samples to random samples of X,
+     * at most half of the batch is used, the centroids with the
+     * smallest counts first
+    */
+    void reassign_centroids(const MatType& X) {
+        std::size_t num_samples = X.rows();
+        DataType min_count = counts_.maxCoeff() * reassignment_ratio_;
+        std::vector<std::size_t> to_reassign;
+        for (std::size_t c = 0; c < num_clusters_; ++c) {
+            if (counts_(c) < min_count) {
+                to_reassign.push_back(c);
+            }
+        }
+        std::size_t max_reassign = std::max<std::size_t>(num_samples / 2, 1);
+        if (to_reassign.size() > max_reassign) {
+            std::stable_sort(to_reassign.begin(), to_reassign.end(),
+                [this](std::size_t c1, std::size_t c2) {
+                    return counts_(c1) < counts_(c2);
+                }
+            );
+            to_reassign.resize(max_reassign);
+        }
+        if (to_reassign.empty()) {
+            return ;
+        }
+
+        // reassigned centroids restart from the smallest remaining count,
+        // so that they are not moved again by the next batch
+        std::vector<bool> reassigned(num_clusters_, false);
+        for (std::size_t c : to_reassign) {
+            reassigned[c] = true;
+        }
+        DataType new_count = ConstType<DataType>::infinity();
+        for (std::size_t c = 0; c < num_clusters_; ++c) {
+            if (!reassigned[c]) {
+                new_count = std::min(new_count, counts_(c));
+            }
+        }
+        if (new_count == ConstType<DataType>::infinity()) {
+            new_count = 0;
+        }
+
+        IdxVecType index = random::permutation<IdxVecType>(num_samples, generator_);
+        for (std::size_t i = 0; i < to_reassign.size(); ++i) {
+            centroids_.row(to_reassign[i]) = X.row(index(i));
+            counts_(to_reassign[i]) = new_count;
+        }
+    }
+
+    /**
+     * one mini-batch step, the new centroid is the weighted mean of its
+     * old position and of the batch samples assigned to it
+     *
+     * @param shift output sum of the centroid shifts
+     * @return the inertia of the batch
+    */
+    DataType minibatch_step(const MatType& X, DataType& shift) {
+        std::size_t num_samples = X.rows(), num_features = X.cols();
+        IdxVecType labels;
+        VecType min_dist;
+        std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+            X, centroids_, "sqeuclidean", n_jobs_
+        );
+
+        MatType sums = MatType::Zero(num_clusters_, num_features);
+        VecType batch_counts = VecType::Zero(num_clusters_);
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            sums.row(labels(i)) += X.row(i);
+            batch_counts(labels(i)) += 1;
+        }
+
+        shift = 0;
+        for (std::size_t c = 0; c < num_clusters_; ++c) {
+            if (batch_counts(c) > 0) {
+                counts_(c) += batch_counts(c);
+                // learning rate 1 / count for each sample of the batch
+                MatType delta = (sums.row(c) - batch_counts(c) * centroids_.row(c)) / counts_(c);
+                centroids_.row(c) += delta;
+                shift += delta.norm();
+            }
+        }
+
+        // reassign centroids every 10 x num_clusters samples
+        if (reassignment_ratio_ > 0) {
+            num_since_reassign_ += num_samples;
+            if (num_since_reassign_ >= 10 * num_clusters_) {
+                reassign_centroids(X);
+                num_since_reassign_ = 0;
+            }
+        }
+        ++num_steps_;
+        return min_dist.sum();
+    }
+
+    /**
+     * fit on the batches of a data source, the centroids are initialized
+     * on the first samples of the source, then each epoch runs one step
+     * per batch until convergence
+    */
+    void fit_source(data::DataSource<DataType>& source) {
+        initialized_ = false;
+        std::size_t num_features = source.num_features();
+        std::size_t init_size = std::max(3 * batch_size_, num_clusters_);
+
+        // gather the first batches to initialize the centroids
+        MatType X_batch, X_init(0, num_features);
+        VecType y_batch;
+        std::size_t num_init = 0, num_rows;
+        source.reset();
+        while (num_init < init_size &&
+            (num_rows = source.next_batch(X_batch, y_batch, batch_size_)) > 0) {
+            X_init.conservativeResize(num_init + num_rows, Eigen::NoChange);
+            X_init.middleRows(num_init, num_rows) = X_batch;
+            num_init += num_rows;
+        }
+        init_centroids(X_init);
+
+        // exponentially weighted average of the mean inertia of the batches
+        DataType ewa_inertia = 0, best_inertia = ConstType<DataType>::infinity();
+        std::size_t num_no_improvement = 0, epoch_size = 0;
+        for (std::size_t iter = 0; iter < max_iter_; ++iter) {
+            std::size_t num_seen = 0;
+            source.reset();
+            while ((num_rows = source.next_batch(X_batch, y_batch, batch_size_)) > 0) {
+                num_seen += num_rows;
+                DataType shift;
+                DataType batch_inertia = minibatch_step(X_batch, shift) / num_rows;
+
+                // the number of samples is unknown during the first epoch
+                std::size_t num_samples = epoch_size > 0 ? epoch_size : num_seen;
+                DataType alpha = std::min<DataType>(
+                    2.0 * num_rows / (num_samples + 1), 1.0
+                );
+                ewa_inertia = (num_steps_ == 1) ? batch_inertia :
+                    ewa_inertia * (1 - alpha) + batch_inertia * alpha;
+
+                if (tol_ > 0 && shift < tol_) {
+                    return ;
+                }
+                if (max_no_improvement_ > 0) {
+                    if (ewa_inertia < best_inertia) {
+                        best_inertia = ewa_inertia;
+                        num_no_improvement = 0;
+                    }
+                    else if (++num_no_improvement >= max_no_improvement_) {
+                        return ;
+                    }
+                }
+            }
+            epoch_size = num_seen;
+        }
+    }
+
+public:
+    MiniBatchKMeans(): init_("kmeans++"),
+        num_clusters_(3),
+        batch_size_(1024),
+        max_iter_(100),
+        tol_(0.0),
+        max_no_improvement_(10),
+        reassignment_ratio_(0.01),
+        random_state_(-1),
+        n_jobs_(1),
+        initialized_(false),
+        num_steps_(0),
+        num_since_reassign_(0),
+        generator_(random::make_generator(-1)) {};
+
+    MiniBatchKMeans(std::string init,
+        std::size_t num_clusters,
+        std::size_t batch_size,
+        std::size_t max_iter,
+        double tol,
+        std::size_t max_no_improvement,
+        double reassignment_ratio,
+        long random_state = -1,
+        int n_jobs = 1): init_(init),
+            num_clusters_(num_clusters),
+            batch_size_(batch_size),
+            max_iter_(max_iter),
+            tol_(tol),
+            max_no_improvement_(max_no_improvement),
+            reassignment_ratio_(reassignment_ratio),
+            random_state_(random_state),
+            n_jobs_(n_jobs),
+            initialized_(false),
+            num_steps_(0),
+            num_since_reassign_(0),
+            generator_(random::make_generator(random_state)) {
+        if (batch_size == 0) {
+            throw std::invalid_argument("batch_size must be positive.");
+        }
+    };
+
+    ~MiniBatchKMeans() {};
+
+    /**
+     * fit dataset to compute k-means clustering,
+     * batches are sampled from X at each epoch
+    */
+    void fit(const MatType& X) {
+        generator_ = random::make_generator(random_state_);
+        long seed = static_cast<long>(generator_.next_uint64() >> 1);
+        // labels are not used, the source needs a label vector
+        VecType y = VecType::Zero(X.rows());
+        data::InMemoryDataSource<DataType> source(X, y, true, "epoch", 64, seed);
+        fit_source(source);
+    }
+
+    /**
+     * fit on a streaming data source, only one batch is in memory,
+     * labels of the source are ignored
+    */
+    void fit(data::DataSource<DataType>& source) {
+        generator_ = random::make_generator(random_state_);
+        fit_source(source);
+    }
+
+    /**
+     * update the centroids with a single mini-batch, the first call
+     * initializes the centroids on X, so it needs at least num_clusters samples
+     * @param X  ndarray of shape [num_samples, num_features]
+    */
+    void partial_fit(const MatType& X) {
+        if (!initialized_) {
+            init_centroids(X);
+        }
+        DataType shift;
+        minibatch_step(X, shift);
+    }
+
+    /**
+     * Predict the labels for the input dataset
+     * @param X  ndarray of shape [num_samples, num_features]
+     *    the input dataset
+    */
+    const VecType predict(const MatType& X) const {
+        IdxVecType labels;
+        VecType min_dist;
+        std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+            X, centroids_, "sqeuclidean", n_jobs_
+        );
+        VecType y_pred = labels.template cast<DataType>();
+        return y_pred;
+    }
+
+    /**
+     * get the centroids of shape [num_clusters, num_features]
+    */
+    const MatType get_centroids() const {
+        return centroids_;
+    }
+
+    /**
+     * get the number of samples seen by each centroid
+    */
+    const VecType get_counts() const {
+        return counts_;
+    }
+
+};
+
+} // cluster_model
+} // openml
+
+#endif /*METHODS_CLUSTER_MINI_BATCH_KMEANS_HPP*/
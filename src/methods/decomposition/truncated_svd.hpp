@@ -14,7 +14,8 @@ namespace decomposition {
  * to a lower dimesional space, input data shoule be centered 
  *  
  * @param n_components Number of components to keep
- * @param 
+ * @param random_state seed of the randomized solver, default -1 means
+ *      the generator is taken from the global seed
 */
 template<typename DataType>
 class TruncatedSVD: public BaseDecompositionModel<DataType> {
@@ -28,6 +29,7 @@ private:
     std::size_t num_oversamples_;
     std::string solver_;
     std::string power_iter_normalizer_;
+    long random_state_;
     
 protected:
     void fit_data(const MatType& X) {       
@@ -39,7 +41,8 @@ protected:
                 num_oversamples_, 
                 num_iters_, 
                 power_iter_normalizer_, 
-                true);
+                true, 
+                random_state_);
             X_transformed = X * Vt.transpose();
         }
 
@@ -67,17 +70,20 @@ public:
         num_oversamples_(2), 
         num_iters_(4),
         solver_("randomized"), 
-        power_iter_normalizer_("LU") {};
+        power_iter_normalizer_("LU"), 
+        random_state_(-1) {};
 
     TruncatedSVD(std::size_t num_components, 
         std::size_t num_oversamples,
         std::size_t num_iters,
         std::string solver, 
-        std::string power_iter_normalizer): BaseDecompositionModel<DataType>(num_components),
+        std::string power_iter_normalizer, 
+        long random_state = -1): BaseDecompositionModel<DataType>(num_components),
             num_oversamples_(num_oversamples), 
             num_iters_(num_iters),
             solver_(solver), 
-            power_iter_normalizer_(power_iter_normalizer) {};
+            power_iter_normalizer_(power_iter_normalizer), 
+            random_state_(random_state) {};
 
 };  
 
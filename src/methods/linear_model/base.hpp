@@ -31,6 +31,14 @@ protected:
     virtual void fit_data(const MatType& X, 
         const VecType& y) = 0;
 
+    /**
+     * fit dataset from a stream of mini-batches, 
+     * only supported by models with a mini-batch solver
+    */
+    virtual void fit_source(data::DataSource<DataType>& /*source*/) {
+        throw std::runtime_error("The model does not support streaming data source.");
+    };
+
     /**
      * Calculate the predicted value y_pred for test dataset
      * 
@@ -89,6 +97,16 @@ public:
         this->fit_data(X, y);
     }
 
+    /**
+     * Fit the model from a data source, samples are pulled in 
+     * mini-batches so the dataset does not have to fit in memory.
+     * 
+     * @param source data source of samples and target values
+    */
+    void fit(data::DataSource<DataType>& source) {
+        this->fit_source(source);
+    }
+
     /**
      * Predict class labels for samples in X.
      * 
@@ -35,37 +35,22 @@ private:
     std::string linesearch_condition_;
 
 protected:
+    using OptimizerType = optimizer::BaseOptimizer<
+        DataType, 
+        loss::LogLoss<DataType>, 
+        optimizer::VanillaUpdate<DataType>, 
+        optimizer::StepDecay<DataType>>;
+
     /**
-     * fit dataset
+     * create the optimizer of given solver and penalty
+     * @param w initial weight vector including the intercept term
     */
-    void fit_data(const MatType& X, 
-        const VecType& y) {
-        
-        MatType X_new = X;
-        VecType y_new = y;
-        
-        // logistic regression must have intercept term, because we want to 
-        // find a decision boundary that is able to seperate 2 class data,
-        // intercept term does not exist, the decision boundary no doubt 
-        // pass through the origin point.
-        std::size_t num_samples = X.rows(), num_features = X.cols();
-        VecType ones(num_samples);
-        ones.fill(1.0);
-        X_new.conservativeResize(num_samples, num_features + 1);
-        X_new.col(num_features) = ones;
-
-        VecType w(num_features + 1);
-        w.setRandom();
-        
+    std::unique_ptr<OptimizerType> create_optimizer(const VecType& w) const {
         loss::LogLoss<DataType> log_loss(lambda_);
         optimizer::VanillaUpdate<DataType> w_update;
         optimizer::StepDecay<DataType> lr_decay(alpha_);
         
-        std::unique_ptr<optimizer::BaseOptimizer<
-            DataType, 
-            loss::LogLoss<DataType>, 
-            optimizer::VanillaUpdate<DataType>, 
-            optimizer::StepDecay<DataType>>> opt;     
+        std::unique_ptr<OptimizerType> opt;     
         if (penalty_ == "l2" || penalty_ == "None") {
             if (solver_ == "sgd") {
                 opt = std::make_unique<optimizer::SGD<
@@ -147,10 +132,55 @@ protected:
                 "Penalty type {l1, l2, none}, default=l2"
             );
         }
+        return opt;
+    }
+
+    /**
+     * fit dataset
+    */
+    void fit_data(const MatType& X, 
+        const VecType& y) {
+        
+        MatType X_new = X;
+        VecType y_new = y;
+        
+        // logistic regression must have intercept term, because we want to 
+        // find a decision boundary that is able to seperate 2 class data,
+        // intercept term does not exist, the decision boundary no doubt 
+        // pass through the origin point.
+        std::size_t num_samples = X.rows(), num_features = X.cols();
+        VecType ones(num_samples);
+        ones.fill(1.0);
+        X_new.conservativeResize(num_samples, num_features + 1);
+        X_new.col(num_features) = ones;
+
+        VecType w(num_features + 1);
+        w.setRandom();
+        
+        std::unique_ptr<OptimizerType> opt = create_optimizer(w);
         opt->optimize(X_new, y_new);
         this->w_ = opt->get_coef();
     };
 
+    /**
+     * fit dataset from a data source, the intercept column is 
+     * appended to each mini-batch
+    */
+    void fit_source(data::DataSource<DataType>& source) {
+        if (solver_ != "sgd" && solver_ != "sag") {
+            throw std::invalid_argument(
+                "Only SGD and SAG solvers support streaming data source."
+            );
+        }
+        data::InterceptDataSource<DataType> intercept_source(source);
+        VecType w(intercept_source.num_features());
+        w.setRandom();
+
+        std::unique_ptr<OptimizerType> opt = create_optimizer(w);
+        opt->optimize(intercept_source);
+        this->w_ = opt->get_coef();
+    };
+
     const MatType predict_label_prob(const MatType& X) const {
         // calculate the desicion boundary func
         std::size_t num_samples = X.rows();
@@ -58,14 +58,44 @@ protected:
         VecType w(num_features);
         w.setRandom();
 
+        auto sgd = create_optimizer(w);
+        sgd.optimize(X_new, y_new);
+        this->w_ = sgd.get_coef();
+    };
+
+    /**fit data from a source of mini-batches*/
+    void fit_source(data::DataSource<DataType>& source) {
+        if (this->intercept_) {
+            data::InterceptDataSource<DataType> intercept_source(source);
+            VecType w(intercept_source.num_features());
+            w.setRandom();
+            auto sgd = create_optimizer(w);
+            sgd.optimize(intercept_source);
+            this->w_ = sgd.get_coef();
+        }
+        else {
+            VecType w(source.num_features());
+            w.setRandom();
+            auto sgd = create_optimizer(w);
+            sgd.optimize(source);
+            this->w_ = sgd.get_coef();
+        }
+    };
+
+    /**create the sgd optimizer with hinge loss*/
+    optimizer::SGD<DataType, 
+        loss::HingeLoss<DataType>, 
+        optimizer::VanillaUpdate<DataType>, 
+        optimizer::StepDecay<DataType>> create_optimizer(const VecType& w) const {
+        
         loss::HingeLoss<DataType> hinge_loss(lambda_, 0.0);
         optimizer::StepDecay<DataType> lr_decay(alpha_);
         optimizer::VanillaUpdate<DataType> weight_update;
 
-        optimizer::SGD<DataType, 
+        return optimizer::SGD<DataType, 
             loss::HingeLoss<DataType>, 
             optimizer::VanillaUpdate<DataType>, 
-            optimizer::StepDecay<DataType>> sgd(
+            optimizer::StepDecay<DataType>>(
                 w, 
                 hinge_loss, 
                 weight_update, 
@@ -76,9 +106,7 @@ protected:
                 tol_, 
                 shuffle_, 
                 verbose_);
-        sgd.optimize(X, y);
-        this->w_ = sgd.get_coef();
-    };
+    }
 
 public:
     /**
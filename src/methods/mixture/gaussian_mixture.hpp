@@ -26,6 +26,11 @@ namespace mixture_model {
  *    The convergence threshold.
  * @param reg_covar_: double, default 1e-6
  *    Non-negative regularization added to the diagonal of covariance
+ * @param random_state: long, default -1
+ *    Seed of the random initialization, a negative value means 
+ *    the generator is taken from the global seed.
+ * @param n_jobs: int, default 1
+ *    Number of threads of the E-step, -1 means using all cores.
 */
 template<typename DataType>
 class GaussianMixture {
@@ -39,9 +44,11 @@ private:
     std::size_t num_init_;
     std::size_t num_components_;
     std::string init_params_;
+    long random_state_;
     std::string covariance_type_;
     double tol_;
     double reg_covar_;
+    int n_jobs_;
     
     std::vector<MatType> covariances_;
     std::vector<MatType> precisions_;
@@ -270,30 +277,22 @@ private:
 
         MatType log_prob(num_samples, num_components);
 
-        for (std::size_t i = 0; i < num_components; ++i) {
-            MatType prec_chol;
-            if (covariance_type_ == "tied") {
-                prec_chol = precision_chol[0];
-            }
-            else if (covariance_type_ == "full") {
-                prec_chol = precision_chol[i];
+        // samples are processed by blocks of rows in parallel
+        parallel::parallel_for(0, num_samples, 256, n_jobs_, 
+            [&](std::size_t first, std::size_t last) {
+                std::size_t num_rows = last - first;
+                for (std::size_t i = 0; i < num_components; ++i) {
+                    const MatType& prec_chol = (covariance_type_ == "tied") ? 
+                        precision_chol[0] : precision_chol[i];
+                    
+                    MatType mu_prec = means.row(i) * prec_chol;
+                    MatType y = X.middleRows(first, num_rows) * prec_chol;
+                    y.rowwise() -= mu_prec.row(0);
+
+                    log_prob.col(i).segment(first, num_rows) = y.rowwise().squaredNorm();
+                }
             }
-            VecType mu = means.row(i).transpose();
-
-            MatType tmp1(num_samples, num_features);
-            tmp1 = X * prec_chol;
-
-            MatType tmp2(1, num_features);
-            tmp2 = mu.transpose() * prec_chol;
-
-            MatType tmp3(num_samples, num_features);
-            tmp3 = common::repeat<MatType>(tmp2, num_samples, 0);
-
-            MatType y = tmp1.array() - tmp3.array();
-            MatType y_square = y.array().square();
-
-            log_prob.col(i) = math::sum<MatType>(y_square, 1);
-        }
+        );
 
         DataType v = static_cast<DataType>(num_features) * 
             static_cast<DataType>(std::log(2 * M_PI)) * 
@@ -362,11 +361,12 @@ private:
     /**
      * Initialize the model parameters.
     */
-    void initialize_parameters(const MatType& X) {
+    void initialize_parameters(const MatType& X, 
+        random::Philox4x32& generator) {
         std::size_t num_samples = X.rows();
         MatType resp(num_samples, num_components_);
         if (init_params_ == "random") {
-            resp = random::rand<MatType>(num_samples, num_components_);
+            resp = random::rand<MatType>(num_samples, num_components_, 0.0, 1.0, generator);
 
             VecType sum_resp = math::sum<MatType>(resp, 1);
             MatType sum_resp_tmp = common::repeat<MatType>(sum_resp, num_components_, 1);
@@ -460,9 +460,10 @@ private:
         MatType best_means;
         VecType best_weights;
 
+        random::Philox4x32 generator = random::make_generator(random_state_);
         for (std::size_t init = 0; init < num_init_; ++init) {
 
-            initialize_parameters(X);
+            initialize_parameters(X, generator);
             double lower_bound = -ConstType<double>::infinity();
             std::size_t iter;
             for (iter = 0; iter < max_iter_; ++iter) {
@@ -521,9 +522,11 @@ public:
         num_init_(1),
         num_components_(3), 
         init_params_("random"), 
+        random_state_(-1), 
         covariance_type_("full"), 
         tol_(1e-3), 
-        reg_covar_(1e-6) {};
+        reg_covar_(1e-6), 
+        n_jobs_(1) {};
 
     GaussianMixture(std::size_t max_iter,
         std::size_t num_init,
@@ -531,13 +534,17 @@ public:
         std::string init_params,
         std::string covariance_type,
         double tol,
-        double reg_covar): max_iter_(max_iter), 
+        double reg_covar, 
+        long random_state = -1, 
+        int n_jobs = 1): max_iter_(max_iter), 
             num_init_(num_init),
             num_components_(num_components), 
             init_params_(init_params), 
+            random_state_(random_state), 
             covariance_type_(covariance_type), 
             tol_(tol), 
-            reg_covar_(reg_covar) {};
+            reg_covar_(reg_covar), 
+            n_jobs_(n_jobs) {};
 
     ~GaussianMixture() {};
 
@@ -0,0 +1,394 @@
+#ifndef METHOD_NEIGHBORS_IVF_PQ_HPP
+#define METHOD_NEIGHBORS_IVF_PQ_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+#include "../cluster/kmeans.hpp"
+using namespace openml;
+
+namespace openml {
+namespace neighbors {
+
+/**
+ * maximum number of centroids of a sub-quantizer, codes are one byte
+*/
+constexpr std::size_t IVFPQ_MAX_CODES = 256;
+
+/**
+ * Inverted file index with product quantization, Jegou et al. 2011
+ * "Product quantization for nearest neighbor search".
+ *
+ * A coarse k-means quantizer splits the vectors into num_lists inverted
+ * lists. The residual of a vector to its coarse centroid is cut into
+ * num_subquantizers sub-vectors, each one is replaced by the index of its
+ * closest centroid in the codebook of the subspace, so a vector is stored
+ * as num_subquantizers bytes instead of num_features values. The coarse
+ * centroids and the codebooks are trained with cluster::KMeans.
+ *
+ * A query visits the num_probes closest lists. For each list a table of
+ * the squared distances between the query residual and every codebook
+ * centroid is computed once, the distance to a code is then a sum of
+ * num_subquantizers table lookups (asymmetric distance computation).
+ * Tables are stored in float, with AVX2 the lookups of 8 sub-quantizers
+ * are done by a single gather.
+ *
+ * @param num_lists size_t, default 100, number of inverted lists
+ * @param num_subquantizers size_t, default 8, number of bytes of a code,
+ *      it must divide num_features
+ * @param num_probes size_t, default 8, number of lists visited by a query,
+ *      the recall/latency trade off
+ * @param max_iter size_t, default 25, maximum number of k-means iterations
+ * @param random_state long, default -1, seed of the k-means initializations
+ * @param n_jobs number of threads for training, encoding and queries,
+ *      default 1, -1 means using all cores
+*/
+template<typename DataType>
+class IVFPQ {
+private:
+    // define matrix and vector Eigen type
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using CodeType = std::uint8_t;
+    using NNType = std::pair<float, Eigen::Index>;
+
+    std::size_t num_lists_;
+    std::size_t num_subquantizers_;
+    std::size_t num_probes_;
+    std::size_t max_iter_;
+    long random_state_;
+    int n_jobs_;
+
+    bool trained_;
+    std::size_t num_features_;
+    std::size_t sub_dim_;
+    std::size_t num_codes_;
+    std::size_t num_points_;
+    MatType coarse_centroids_;
+    // codebook of a subspace, of shape (num_codes, sub_dim)
+    std::vector<MatType> codebooks_;
+    // codes of a list, num_subquantizers bytes per vector
+    std::vector<std::vector<CodeType>> list_codes_;
+    std::vector<std::vector<Eigen::Index>> list_ids_;
+
+protected:
+    /**
+     * index of the closest coarse centroid of each row of X and
+     * the residuals of the rows to their centroid
+    */
+    IdxVecType assign_lists(const MatType& X, MatType& residuals) const {
+        IdxVecType labels;
+        VecType min_dist;
+        std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+            X, coarse_centroids_, "sqeuclidean", n_jobs_
+        );
+        residuals = X;
+        for (Eigen::Index i = 0; i < X.rows(); ++i) {
+            residuals.row(i) -= coarse_centroids_.row(labels(i));
+        }
+        return labels;
+    }
+
+    /**
+     * encode residuals, codes are stored row by row
+    */
+    std::vector<CodeType> encode(const MatType& residuals) const {
+        std::size_t num_samples = residuals.rows();
+        std::vector<CodeType> codes(num_samples * num_subquantizers_);
+        for (std::size_t j = 0; j < num_subquantizers_; ++j) {
+            MatType sub = residuals.middleCols(j * sub_dim_, sub_dim_);
+            IdxVecType labels;
+            VecType min_dist;
+            std::tie(labels, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+                sub, codebooks_[j], "sqeuclidean", n_jobs_
+            );
+            for (std::size_t i = 0; i < num_samples; ++i) {
+                codes[i * num_subquantizers_ + j] = static_cast<CodeType>(labels(i));
+            }
+        }
+        return codes;
+    }
+
+    /**
+     * squared distances between the sub-vectors of a residual and the
+     * centroids of the codebooks, table[j * num_codes + c]
+    */
+    void compute_table(const VecType& residual, std::vector<float>& table) const {
+        for (std::size_t j = 0; j < num_subquantizers_; ++j) {
+            VecType dist = (codebooks_[j].rowwise() -
+                residual.segment(j * sub_dim_, sub_dim_).transpose()).rowwise().squaredNorm();
+            for (std::size_t c = 0; c < num_codes_; ++c) {
+                table[j * num_codes_ + c] = static_cast<float>(dist(c));
+            }
+        }
+    }
+
+    /**
+     * asymmetric distance of a code, sum of the table entries of its bytes
+    */
+    float adc_distance(const CodeType* code, const float* table) const {
+        float dist = 0;
+        std::size_t j = 0;
+#if defined(__AVX2__)
+        // lane l reads the table of sub-quantizer j + l
+        const __m256i offsets = _mm256_mullo_epi32(
+            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+            _mm256_set1_epi32(static_cast<int>(num_codes_))
+        );
+        __m256 acc = _mm256_setzero_ps();
+        for (; j + 8 <= num_subquantizers_; j += 8) {
+            __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(code + j));
+            __m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(bytes), offsets);
+            acc = _mm256_add_ps(acc, _mm256_i32gather_ps(table + j * num_codes_, index, 4));
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_hadd_ps(sum, sum);
+        sum = _mm_hadd_ps(sum, sum);
+        dist = _mm_cvtss_f32(sum);
+#endif
+        for (; j < num_subquantizers_; ++j) {
+            dist += table[j * num_codes_ + code[j]];
+        }
+        return dist;
+    }
+
+public:
+    IVFPQ(): num_lists_(100),
+        num_subquantizers_(8),
+        num_probes_(8),
+        max_iter_(25),
+        random_state_(-1),
+        n_jobs_(1),
+        trained_(false),
+        num_features_(0),
+        sub_dim_(0),
+        num_codes_(0),
+        num_points_(0) {};
+
+    IVFPQ(std::size_t num_lists,
+        std::size_t num_subquantizers,
+        std::size_t num_probes,
+        std::size_t max_iter = 25,
+        long random_state = -1,
+        int n_jobs = 1): num_lists_(num_lists),
+            num_subquantizers_(num_subquantizers),
+            num_probes_(num_probes),
+            max_iter_(max_iter),
+            random_state_(random_state),
+            n_jobs_(n_jobs),
+            trained_(false),
+            num_features_(0),
+            sub_dim_(0),
+            num_codes_(0),
+            num_points_(0) {
+        if (num_lists == 0 || num_subquantizers == 0) {
+            throw std::invalid_argument("num_lists and num_subquantizers must be positive.");
+        }
+    };
+
+    ~IVFPQ() {};
+
+    /**
+     * train the coarse centroids and the codebooks, the index is emptied,
+     * X is a sample of the vectors, it is not stored
+     * @param X ndarray of shape (num_samples, num_features)
+    */
+    void train(const MatType& X) {
+        std::size_t num_samples = X.rows();
+        if (X.cols() % num_subquantizers_ != 0) {
+            std::ostringstream err_msg;
+            err_msg << "num_subquantizers = " << num_subquantizers_
+                    << " must divide num_features = " << X.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (num_samples < num_lists_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected at least num_lists = " << num_lists_
+                    << " training samples, but got " << num_samples << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        num_features_ = X.cols();
+        sub_dim_ = num_features_ / num_subquantizers_;
+        num_codes_ = std::min(IVFPQ_MAX_CODES, num_samples);
+
+        random::Philox4x32 generator = random::make_generator(random_state_);
+        long seed = static_cast<long>(generator.next_uint64() >> 1);
+        cluster::KMeans<DataType> coarse("kmeans++", 1, num_lists_, max_iter_, 1e-4, seed, n_jobs_);
+        coarse.fit(X);
+        coarse_centroids_ = coarse.get_centroids();
+
+        MatType residuals;
+        assign_lists(X, residuals);
+
+        // the codebooks are independent, one k-means per subspace,
+        // subspaces have few features, hamerly bounds prune best there
+        std::vector<long> seeds(num_subquantizers_);
+        for (std::size_t j = 0; j < num_subquantizers_; ++j) {
+            seeds[j] = static_cast<long>(generator.next_uint64() >> 1);
+        }
+        codebooks_.resize(num_subquantizers_);
+        parallel::parallel_for(0, num_subquantizers_, 1, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t j = first; j < last; ++j) {
+                    cluster::KMeans<DataType> kmeans(
+                        "kmeans++", 1, num_codes_, max_iter_, 1e-4, seeds[j], 1, "hamerly"
+                    );
+                    MatType sub = residuals.middleCols(j * sub_dim_, sub_dim_);
+                    kmeans.fit(sub);
+                    codebooks_[j] = kmeans.get_centroids();
+                }
+            }
+        );
+
+        list_codes_.assign(num_lists_, std::vector<CodeType>());
+        list_ids_.assign(num_lists_, std::vector<Eigen::Index>());
+        num_points_ = 0;
+        trained_ = true;
+    }
+
+    /**
+     * encode the rows of X and append them to their lists, the ids of
+     * new vectors follow the existing ones
+    */
+    void add(const MatType& X) {
+        if (!trained_) {
+            throw std::runtime_error("The index must be trained before adding vectors.");
+        }
+        if (static_cast<std::size_t>(X.cols()) != num_features_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected " << num_features_ << " features, but got "
+                    << X.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        std::size_t num_samples = X.rows();
+        MatType residuals;
+        IdxVecType labels = assign_lists(X, residuals);
+        std::vector<CodeType> codes = encode(residuals);
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            std::vector<CodeType>& list = list_codes_[labels(i)];
+            list.insert(list.end(), codes.begin() + i * num_subquantizers_,
+                codes.begin() + (i + 1) * num_subquantizers_);
+            list_ids_[labels(i)].push_back(num_points_ + i);
+        }
+        num_points_ += num_samples;
+    }
+
+    /**
+     * train the index on X and add X
+    */
+    void fit(const MatType& X) {
+        train(X);
+        add(X);
+    }
+
+    /**
+     * approximate k nearest neighbors of a batch of points, distances
+     * are the euclidean distances to the decoded vectors
+     *
+     * @param data ndarray of shape (num_samples, num_features)
+     * @param distances output distances sorted by increasing distance
+     * @param indices output ids of the neighbors, -1 if the visited
+     *      lists have fewer than k vectors
+    */
+    void query(const MatType& data,
+        std::size_t k,
+        MatType& distances,
+        IdxMatType& indices) const {
+
+        if (!trained_) {
+            throw std::runtime_error("The index must be trained before querying.");
+        }
+        if (k == 0 || k > num_points_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected 0 < k <= num_points of the index, but got k = "
+                    << k << ", num_points = " << num_points_ << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        std::size_t num_samples = data.rows();
+        std::size_t num_probes = std::min(num_probes_, num_lists_);
+        distances.resize(num_samples, k);
+        indices.resize(num_samples, k);
+
+        MatType coarse_dist = metric::pairwise_distances<MatType>(
+            data, coarse_centroids_, "sqeuclidean", n_jobs_
+        );
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                std::vector<float> table(num_subquantizers_ * num_codes_);
+                std::vector<std::size_t> lists(num_lists_);
+                std::vector<NNType> heap;
+                heap.reserve(k);
+                for (std::size_t i = first; i < last; ++i) {
+                    std::iota(lists.begin(), lists.end(), 0);
+                    std::partial_sort(lists.begin(), lists.begin() + num_probes, lists.end(),
+                        [&](std::size_t l1, std::size_t l2) {
+                            return coarse_dist(i, l1) < coarse_dist(i, l2);
+                        }
+                    );
+                    heap.clear();
+                    for (std::size_t p = 0; p < num_probes; ++p) {
+                        std::size_t l = lists[p];
+                        VecType residual = (data.row(i) - coarse_centroids_.row(l)).transpose();
+                        compute_table(residual, table);
+                        const CodeType* codes = list_codes_[l].data();
+                        const std::vector<Eigen::Index>& ids = list_ids_[l];
+                        for (std::size_t t = 0; t < ids.size(); ++t) {
+                            NNType nn(adc_distance(codes + t * num_subquantizers_, table.data()), ids[t]);
+                            if (heap.size() < k) {
+                                heap.push_back(nn);
+                                std::push_heap(heap.begin(), heap.end());
+                            }
+                            else if (nn < heap.front()) {
+                                std::pop_heap(heap.begin(), heap.end());
+                                heap.back() = nn;
+                                std::push_heap(heap.begin(), heap.end());
+                            }
+                        }
+                    }
+                    std::sort_heap(heap.begin(), heap.end());
+                    for (std::size_t j = 0; j < k; ++j) {
+                        if (j < heap.size()) {
+                            distances(i, j) = std::sqrt(std::max<DataType>(heap[j].first, 0));
+                            indices(i, j) = heap[j].second;
+                        }
+                        else {
+                            distances(i, j) = ConstType<DataType>::infinity();
+                            indices(i, j) = -1;
+                        }
+                    }
+                }
+            }
+        );
+    }
+
+    const std::pair<MatType, IdxMatType> query(
+        const MatType& data,
+        std::size_t k) const {
+
+        MatType distances;
+        IdxMatType indices;
+        query(data, k, distances, indices);
+        return std::make_pair(distances, indices);
+    }
+
+    void set_num_probes(std::size_t num_probes) {
+        num_probes_ = num_probes;
+    }
+
+    /**
+     * get the number of bytes of a code
+    */
+    std::size_t get_code_size() const {
+        return num_subquantizers_;
+    }
+
+    std::size_t size() const {
+        return num_points_;
+    }
+
+};
+
+} // neighbors
+} // openml
+
+#endif /*METHOD_NEIGHBORS_IVF_PQ_HPP*/
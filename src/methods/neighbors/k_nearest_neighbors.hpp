@@ -8,88 +8,60 @@ using namespace openml;
 namespace openml {
 namespace neighbors {
 
+/**
+ * k-nearest neighbors classifier.
+ * 
+ * @param solver string, "kdtree", "balltree", "hnsw" or "brute",
+ *      "balltree" supports the metrics of tree::BallTree and 
+ *      prunes better than "kdtree" in high dimension, "hnsw" is an
+ *      approximate search with the default parameters of tree::HNSW,
+ *      for the "euclidean" and "cosine" metrics, "brute" computes the
+ *      distances by blocks of queries and training samples as matrix
+ *      products and keeps the k closest of each query in a bounded heap,
+ *      it supports the metrics of metric::pairwise_distances and is the
+ *      fastest solver for few samples in high dimension
+ * @param n_jobs number of threads for the neighbors search, 
+ *      default 1, -1 means using all cores
+*/
 template<typename DataType>
 class KNearestNeighbors {
 private:
     // define matrix and vector Eigen type
     using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
-    using RowVecType = Eigen::Matrix<DataType, 1, Eigen::Dynamic>;
     using ColVecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
     using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
     using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
-    using NNType = std::pair<DataType, std::size_t>;
 
     std::size_t leaf_size_;
     std::size_t num_neighbors_;
     std::string solver_;
     std::string metric_;
+    int n_jobs_;
 
     MatType X_;
+    ColVecType X_norms_;
     ColVecType y_;
     std::unique_ptr<tree::KDTree<DataType>> tree_;
-
-protected:
-    DataType brute_force(const MatType& X, const ColVecType& y, const RowVecType& samples) {
-        
-        std::vector<DataType> neighbors;
-        std::vector<std::pair<double, DataType>> lookup_dist;
-
-        for (std::size_t i = 0; i < X.row(); ++i) {
-            RowVecType current = X.rows(i);
-            DataType label = y(i, 0);
-            double distance;
-            
-            if (metric_ == "euclidean") {
-                distance = (current - sample).template lpNorm<2>();
-            }
-            else if (metric_ == "manhattan") {
-                distance = (current - sample).template lpNorm<1>();
-            }
-            else {
-                std::ostringstream err_msg;
-                err_msg << "Only support euclidean and manhattan distance." << std::endl;
-                throw std::invalid_argument(err_msg.str());
-
-            }
-            lookup_dist.emplace_back(distance, label);
-        }
-        std::sort(lookup_dist.begin(), lookup_dist.end());
-        for (std::size_t i = 0; i < num_neighbors_; i++) {
-            auto label = lookup_dist.at(i).second;
-            neighbors.push_back(label);
-        }
-        std::unordered_map<DataType, std::size_t> frequency;
-        for (auto neighbor : neighbors) {
-            ++frequency[neighbor];
-        }
-        std::pair<DataType, std::size_t> pred_label;
-        pred_label.first = -1;
-        pred_label.second = -1;
-        for (auto& kv : frequency) {
-            if (kv.second > pred_label.second) {
-                pred_label.second = kv.second;
-                pred_label.first = kv.first;
-            }
-        }
-        return pred_label.first;
-
-    }
-      
+    std::unique_ptr<tree::BallTree<DataType>> ball_tree_;
+    std::unique_ptr<tree::HNSW<DataType>> hnsw_;
 
 public:
     KNearestNeighbors(): leaf_size_(10),
         num_neighbors_(15),  
         solver_("kdtree"),
-        metric_("euclidean") {};
+        metric_("euclidean"), 
+        n_jobs_(1) {};
     
 
     KNearestNeighbors(std::size_t leaf_size, 
         std::size_t num_neighbors,
         std::string solver, 
-        std::string metric): leaf_size_(leaf_size), 
+        std::string metric, 
+        int n_jobs = 1): leaf_size_(leaf_size), 
             num_neighbors_(num_neighbors),
             solver_(solver),
-            metric_(metric) {};
+            metric_(metric), 
+            n_jobs_(n_jobs) {};
 
     
     void fit(const MatType& X, const ColVecType& y) {
@@ -97,44 +69,66 @@ public:
         if (solver_ == "kdtree") {
             // call kdTree via a function pionter
             tree_ = std::make_unique<tree::KDTree<DataType>>(
-                X, leaf_size_, metric_
+                X, leaf_size_, metric_, n_jobs_
             );
             
         }
+        else if (solver_ == "balltree") {
+            ball_tree_ = std::make_unique<tree::BallTree<DataType>>(
+                X, leaf_size_, metric_, n_jobs_
+            );
+        }
+        else if (solver_ == "hnsw") {
+            hnsw_ = std::make_unique<tree::HNSW<DataType>>(
+                16, 200, 50, metric_, -1, n_jobs_
+            );
+            hnsw_->add(X);
+        }
         else if (solver_ == "brute") {
+            metric::check_pairwise_metric(metric_);
             X_ = X;
+            // norms of the training samples are reused by every predict
+            if (metric_ != "manhattan") {
+                X_norms_ = X.rowwise().squaredNorm();
+            }
+        }
+        else {
+            std::ostringstream err_msg;
+            err_msg << "solver must be 'kdtree', 'balltree', 'hnsw' or 'brute', "
+                    << "but got: " << solver_ << std::endl;
+            throw std::invalid_argument(err_msg.str());
         }
         y_ = y;
         
     }
 
     const ColVecType predict(const MatType& X) {
-        ColVecType pred_label;
+        MatType neighbor_dist;
+        IdxMatType neighbor_indice;
         if (solver_ == "kdtree") {
-            MatType neighbor_dist;
-            IdxMatType neighbor_indice;
-            std::tie(neighbor_dist, neighbor_indice) = tree_->query(X, num_neighbors_);
-
-            std::size_t num_samples = X.rows();
-            MatType pred_indice(num_samples, num_neighbors_);
-            for (std::size_t i = 0; i < num_samples; ++i) {
-                pred_indice.row(i) = y_(neighbor_indice.row(i), Eigen::all).transpose();
-            }
-
-            MatType mode, count;
-            std::tie(mode, count) = math::mode<MatType>(pred_indice, 0);
-
-            pred_label = mode;
+            tree_->query(X, num_neighbors_, neighbor_dist, neighbor_indice);
         }
-        else if (solver_ == "brute") {
-            std::size_t num_samples = X.rows();
-            pred_label.resize(num_samples);
-            for (std::size_t i = 0; i < num_samples; ++i) {
-                DataType lable = brute_force(X_, y_, X.row(i));
-                pred_label(i, 0) = lable;
-            }
+        else if (solver_ == "balltree") {
+            ball_tree_->query(X, num_neighbors_, neighbor_dist, neighbor_indice);
         }
-        
+        else if (solver_ == "hnsw") {
+            hnsw_->query(X, num_neighbors_, neighbor_dist, neighbor_indice);
+        }
+        else {
+            std::tie(neighbor_dist, neighbor_indice) = metric::pairwise_distances_topk<MatType, IdxMatType, ColVecType>(
+                X, X_, num_neighbors_, metric_, n_jobs_, nullptr, &X_norms_
+            );
+        }
+
+        std::size_t num_samples = X.rows();
+        MatType pred_indice(num_samples, num_neighbors_);
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            pred_indice.row(i) = y_(neighbor_indice.row(i), Eigen::all).transpose();
+        }
+
+        MatType mode, count;
+        std::tie(mode, count) = math::mode<MatType>(pred_indice, 1);
+        ColVecType pred_label = mode;
         return pred_label;
     }
 
@@ -0,0 +1,320 @@
+#ifndef METHOD_NEIGHBORS_KERNEL_DENSITY_HPP
+#define METHOD_NEIGHBORS_KERNEL_DENSITY_HPP
+#include "../../prereqs.hpp"
+#include "../../core.hpp"
+using namespace openml;
+
+namespace openml {
+namespace neighbors {
+
+/**
+ * Kernel density estimation with a space partitioning tree,
+ * Gray and Moore 2003 "Nonparametric density estimation: toward
+ * computational tractability".
+ *
+ * The density at a point is the mean of the kernel of its distances to
+ * the training samples. The kernel decreases with the distance, so the
+ * distance bounds of a node, from the box of a tree::KDTree or the ball
+ * of a tree::BallTree, bound the sum of the kernels of its points. A
+ * node is estimated by the midpoint of these bounds, the node of largest
+ * error is split, or computed exactly for a leaf, until the total error
+ * is below atol + rtol * (lower bound of the density), so the estimated
+ * density is within atol + rtol * density of the exact one. Nodes out of
+ * the support of a compact kernel or within the flat part of the tophat
+ * kernel have no error and are never split.
+ *
+ * @param bandwidth double, default 1.0, the bandwidth of the kernel
+ * @param kernel string, "gaussian", "epanechnikov" or "tophat"
+ * @param algorithm string, "kdtree" or "balltree"
+ * @param atol double, default 0, absolute tolerance of the density
+ * @param rtol double, default 0, relative tolerance of the density,
+ *      atol = rtol = 0 give the exact density
+ * @param leaf_size size_t, default 40, leaf size of the tree
+ * @param n_jobs number of threads for score_samples, default 1,
+ *      -1 means using all cores
+*/
+template<typename DataType>
+class KernelDensity {
+private:
+    // define matrix and vector Eigen type
+    using MatType = Eigen::Matrix<DataType, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
+    // error of the midpoint of the bounds of the kernel sum of the 
+    // points of a node, the lower bound and the node
+    using NodeBoundType = std::tuple<DataType, DataType, std::size_t>;
+
+    // the kernel as an enum, strings are not compared per distance
+    enum class KernelType {gaussian, epanechnikov, tophat};
+
+    double bandwidth_;
+    std::string kernel_;
+    std::string algorithm_;
+    double atol_;
+    double rtol_;
+    std::size_t leaf_size_;
+    int n_jobs_;
+    KernelType kernel_type_;
+
+    std::size_t num_samples_;
+    std::size_t num_features_;
+    std::unique_ptr<tree::KDTree<DataType>> kd_tree_;
+    std::unique_ptr<tree::BallTree<DataType>> ball_tree_;
+
+protected:
+    /**
+     * kernel of a squared distance, without its normalization
+    */
+    DataType kernel(DataType sq_dist) const {
+        DataType u2 = sq_dist / static_cast<DataType>(bandwidth_ * bandwidth_);
+        if (kernel_type_ == KernelType::gaussian) {
+            return std::exp(-u2 / 2);
+        }
+        else if (kernel_type_ == KernelType::epanechnikov) {
+            return std::max<DataType>(1 - u2, 0);
+        }
+        return (u2 < 1) ? 1 : 0;
+    }
+
+    /**
+     * log of the normalization of the kernel in num_features dimensions,
+     * the tophat and the epanechnikov kernels are normalized by the
+     * volume of the ball of radius bandwidth
+    */
+    double log_kernel_norm() const {
+        double d = static_cast<double>(num_features_);
+        double log_h = d * std::log(bandwidth_);
+        if (kernel_type_ == KernelType::gaussian) {
+            return -0.5 * d * std::log(2.0 * M_PI) - log_h;
+        }
+        double log_volume = 0.5 * d * std::log(M_PI) - std::lgamma(0.5 * d + 1.0);
+        if (kernel_type_ == KernelType::epanechnikov) {
+            return std::log(0.5 * (d + 2.0)) - log_volume - log_h;
+        }
+        return -log_volume - log_h;
+    }
+
+    /**
+     * bound the kernels of the points of a node, a node whose bounds are 
+     * equal is exact and added to sum, else it is pushed on the heap with 
+     * the error of the midpoint of its bounds, which is added to error,
+     * and its lower bound is added to lower
+    */
+    template<typename TreeType>
+    void push_node(const TreeType& tree,
+        const VecType& point,
+        std::size_t node,
+        std::vector<NodeBoundType>& heap,
+        DataType& sum,
+        DataType& lower,
+        DataType& error) const {
+
+        std::size_t begin, end;
+        long left, right;
+        std::tie(begin, end, left, right) = tree.get_node(node);
+        DataType min_dist, max_dist;
+        std::tie(min_dist, max_dist) = tree.get_node_distance_bounds(point, node);
+        DataType count = static_cast<DataType>(end - begin);
+        DataType node_lower = count * kernel(max_dist * max_dist);
+        DataType node_error = (count * kernel(min_dist * min_dist) - node_lower) / 2;
+        if (node_error <= 0) {
+            sum += node_lower;
+            return ;
+        }
+        heap.emplace_back(node_error, node_lower, node);
+        std::push_heap(heap.begin(), heap.end());
+        lower += node_lower;
+        error += node_error;
+    }
+
+    /**
+     * sum of the kernels of the distances between a point and the
+     * training samples, within abs_tol + rtol * sum. The heap holds the 
+     * unresolved nodes, estimated by the midpoints of their bounds, the
+     * node of largest error is split or computed exactly until the total
+     * error is within the tolerance of the lower bound of the sum.
+    */
+    template<typename TreeType>
+    DataType kernel_sum(const TreeType& tree,
+        const VecType& point,
+        DataType abs_tol,
+        std::vector<NodeBoundType>& heap) const {
+
+        const MatType& data = tree.get_data();
+        DataType rel_tol = static_cast<DataType>(rtol_);
+        // sum of the resolved nodes, lower bound and error of the heap
+        DataType sum = 0, lower = 0, error = 0;
+        heap.clear();
+        push_node(tree, point, 0, heap, sum, lower, error);
+        // without tolerance every node with an error is split
+        bool exact = (abs_tol <= 0 && rel_tol <= 0);
+        while (!heap.empty()) {
+            if (!exact && error <= abs_tol + rel_tol * (sum + lower)) {
+                // the running sums drift, recompute them before stopping
+                error = 0;
+                lower = 0;
+                for (const NodeBoundType& entry : heap) {
+                    error += std::get<0>(entry);
+                    lower += std::get<1>(entry);
+                }
+                if (error <= abs_tol + rel_tol * (sum + lower)) {
+                    break;
+                }
+            }
+            DataType node_error, node_lower;
+            std::size_t node;
+            std::tie(node_error, node_lower, node) = heap.front();
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+            lower -= node_lower;
+            error -= node_error;
+
+            std::size_t begin, end;
+            long left, right;
+            std::tie(begin, end, left, right) = tree.get_node(node);
+            if (left < 0) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    sum += kernel((data.col(i) - point).squaredNorm());
+                }
+                continue;
+            }
+            push_node(tree, point, left, heap, sum, lower, error);
+            push_node(tree, point, right, heap, sum, lower, error);
+        }
+        // the midpoints of the nodes left on the heap
+        for (const NodeBoundType& entry : heap) {
+            sum += std::get<1>(entry) + std::get<0>(entry);
+        }
+        return sum;
+    }
+
+    template<typename TreeType>
+    const VecType score_samples_tree(const TreeType& tree, const MatType& X) const {
+        std::size_t num_samples = X.rows();
+        double log_norm = log_kernel_norm() - std::log(static_cast<double>(num_samples_));
+        // atol on the density is a tolerance on the kernel sum
+        DataType abs_tol = (atol_ > 0.0) ? static_cast<DataType>(atol_ * std::exp(-log_norm)) : 0;
+        VecType log_density(num_samples);
+        parallel::parallel_for(0, num_samples, 16, n_jobs_,
+            [&](std::size_t first, std::size_t last) {
+                VecType point(X.cols());
+                std::vector<NodeBoundType> heap;
+                for (std::size_t i = first; i < last; ++i) {
+                    point = X.row(i).transpose();
+                    DataType sum = kernel_sum(tree, point, abs_tol, heap);
+                    log_density(i) = static_cast<DataType>(std::log(static_cast<double>(sum)) + log_norm);
+                }
+            }
+        );
+        return log_density;
+    }
+
+public:
+    KernelDensity(): bandwidth_(1.0),
+        kernel_("gaussian"),
+        algorithm_("kdtree"),
+        atol_(0.0),
+        rtol_(0.0),
+        leaf_size_(40),
+        n_jobs_(1),
+        kernel_type_(KernelType::gaussian),
+        num_samples_(0),
+        num_features_(0) {};
+
+    KernelDensity(double bandwidth,
+        std::string kernel,
+        std::string algorithm = "kdtree",
+        double atol = 0.0,
+        double rtol = 0.0,
+        std::size_t leaf_size = 40,
+        int n_jobs = 1): bandwidth_(bandwidth),
+            kernel_(kernel),
+            algorithm_(algorithm),
+            atol_(atol),
+            rtol_(rtol),
+            leaf_size_(leaf_size),
+            n_jobs_(n_jobs),
+            num_samples_(0),
+            num_features_(0) {
+        if (kernel == "gaussian") {
+            kernel_type_ = KernelType::gaussian;
+        }
+        else if (kernel == "epanechnikov") {
+            kernel_type_ = KernelType::epanechnikov;
+        }
+        else if (kernel == "tophat") {
+            kernel_type_ = KernelType::tophat;
+        }
+        else {
+            std::ostringstream err_msg;
+            err_msg << "kernel must be 'gaussian', 'epanechnikov' or 'tophat', "
+                    << "but got: " << kernel << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (algorithm != "kdtree" && algorithm != "balltree") {
+            std::ostringstream err_msg;
+            err_msg << "algorithm must be 'kdtree' or 'balltree', "
+                    << "but got: " << algorithm << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (bandwidth <= 0.0 || atol < 0.0 || rtol < 0.0) {
+            std::ostringstream err_msg;
+            err_msg << "Expected bandwidth > 0, atol >= 0 and rtol >= 0, but got "
+                    << "bandwidth = " << bandwidth << ", atol = " << atol
+                    << ", rtol = " << rtol << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+    };
+
+    /**
+     * build the tree of the training samples
+     * @param X ndarray of shape (num_samples, num_features)
+    */
+    void fit(const MatType& X) {
+        num_samples_ = X.rows();
+        num_features_ = X.cols();
+        if (algorithm_ == "kdtree") {
+            kd_tree_ = std::make_unique<tree::KDTree<DataType>>(
+                X, leaf_size_, "euclidean", n_jobs_
+            );
+        }
+        else {
+            ball_tree_ = std::make_unique<tree::BallTree<DataType>>(
+                X, leaf_size_, "euclidean", n_jobs_
+            );
+        }
+    }
+
+    /**
+     * log of the density at each sample, -inf out of the support
+     * of a compact kernel, samples are split between threads
+     * @param X ndarray of shape (num_samples, num_features)
+    */
+    const VecType score_samples(const MatType& X) const {
+        if (num_samples_ == 0) {
+            throw std::runtime_error("KernelDensity must be fitted before score_samples.");
+        }
+        if (static_cast<std::size_t>(X.cols()) != num_features_) {
+            std::ostringstream err_msg;
+            err_msg << "Expected " << num_features_ << " features, but got "
+                    << X.cols() << std::endl;
+            throw std::invalid_argument(err_msg.str());
+        }
+        if (algorithm_ == "kdtree") {
+            return score_samples_tree(*kd_tree_, X);
+        }
+        return score_samples_tree(*ball_tree_, X);
+    }
+
+    /**
+     * total log-likelihood of the samples
+    */
+    double score(const MatType& X) const {
+        return static_cast<double>(score_samples(X).sum());
+    }
+
+};
+
+} // neighbors
+} // openml
+
+#endif /*METHOD_NEIGHBORS_KERNEL_DENSITY_HPP*/
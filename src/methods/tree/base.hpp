@@ -15,8 +15,12 @@ private:
     using VecType = Eigen::Matrix<DataType, Eigen::Dynamic, 1>;
     using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
     using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using SplitType = std::tuple<double, std::size_t, DataType>;
     
 protected:
+    // number of threads for the split search
+    int n_jobs_;
+
      /**
      * choose a threshold from a given features vector, first we sort
      * this sample vector, then find the unique threshold
@@ -45,38 +49,50 @@ protected:
      * Iterate through all unique values of feature column i and 
      * calculate the impurity. If this threshold resulted in a 
      * higher information gain than previously recorded save 
-     * the threshold value and the feature index
+     * the threshold value and the feature index.
+     * Features are searched in parallel, the best splits of features 
+     * are compared in feature order, so the result is the same as 
+     * a serial search.
     */
     const std::tuple<double, std::size_t, DataType> best_split(const MatType& X, 
             const VecType& y) const {
         
         std::size_t num_features = X.cols();
         
-        std::size_t best_feature_index = ConstType<std::size_t>::max();
-        DataType best_feature_value = ConstType<DataType>::quiet_NaN();
-        double best_impurity = ConstType<double>::min();
-
-        for (std::size_t feature_index = 0; feature_index < num_features; ++feature_index) {
-            VecType feature_values;
-            feature_values = choose_feature_threshold(X.col(feature_index));
-            for (auto& threshold : feature_values) {
-                std::vector<std::size_t> left_index, right_index;
-                std::tie(left_index, right_index) = data::divide_on_feature<MatType>(X, feature_index, threshold);
-
-                VecType left_y, right_y;
-                left_y = y(left_index);
-                right_y = y(right_index);
-
-                double impurity = this->compute_impurity(y, left_y, right_y);
-                // std::cout << "impurity = " << impurity << std::endl;
-                if (impurity > best_impurity) {
-                    best_impurity = impurity;
-                    best_feature_index = feature_index;
-                    best_feature_value = threshold;
+        const SplitType init_split = std::make_tuple(
+            ConstType<double>::min(), 
+            ConstType<std::size_t>::max(), 
+            ConstType<DataType>::quiet_NaN()
+        );
+
+        auto feature_split = [&](std::size_t first, std::size_t last) {
+            SplitType split = init_split;
+            for (std::size_t feature_index = first; feature_index < last; ++feature_index) {
+                VecType feature_values;
+                feature_values = choose_feature_threshold(X.col(feature_index));
+                for (auto& threshold : feature_values) {
+                    std::vector<std::size_t> left_index, right_index;
+                    std::tie(left_index, right_index) = data::divide_on_feature<MatType>(X, feature_index, threshold);
+
+                    VecType left_y, right_y;
+                    left_y = y(left_index);
+                    right_y = y(right_index);
+
+                    double impurity = this->compute_impurity(y, left_y, right_y);
+                    if (impurity > std::get<0>(split)) {
+                        split = std::make_tuple(impurity, feature_index, threshold);
+                    }
                 }
             }
-        }
-        return std::make_tuple(best_impurity, best_feature_index, best_feature_value);
+            return split;
+        };
+
+        auto best_of = [](const SplitType& best, const SplitType& split) {
+            return (std::get<0>(split) > std::get<0>(best)) ? split : best;
+        };
+
+        return parallel::parallel_reduce(0, num_features, 1, n_jobs_, 
+            init_split, feature_split, best_of);
     }
 
     /** pure virtual function to compute the inpurity */
@@ -89,7 +105,9 @@ protected:
     //     const VecType& y) const = 0;
 
 public:
-    DecisionTree() {};
+    DecisionTree(): n_jobs_(1) {};
+
+    explicit DecisionTree(int n_jobs): n_jobs_(n_jobs) {};
     ~DecisionTree() {};
 
 };
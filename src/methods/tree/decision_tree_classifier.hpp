@@ -245,7 +245,8 @@ public:
         std::size_t min_samples_split, 
         std::size_t min_samples_leaf,
         std::size_t max_depth,
-        double min_impurity_decrease): DecisionTree<DataType>(),
+        double min_impurity_decrease, 
+        int n_jobs = 1): DecisionTree<DataType>(n_jobs),
             criterion_(criterion),
             min_samples_split_(min_samples_split), 
             min_samples_leaf_(min_samples_leaf),
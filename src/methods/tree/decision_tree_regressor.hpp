@@ -248,7 +248,8 @@ public:
         std::size_t min_samples_leaf,
         std::size_t max_depth,
         double min_impurity_decrease,
-        double min_stdev): DecisionTree<DataType>(), 
+        double min_stdev, 
+        int n_jobs = 1): DecisionTree<DataType>(n_jobs), 
             criterion_(criterion), 
             min_samples_split_(min_samples_split), 
             min_samples_leaf_(min_samples_leaf),
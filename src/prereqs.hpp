@@ -4,28 +4,41 @@
 #define _USE_MATH_DEFINES
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cctype>
+#include <cerrno>
 #include <cfloat>
+#include <charconv>
 #include <chrono>
 #include <climits>
 #include <cmath>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <queue>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
 #include <set>
+#include <shared_mutex>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <tuple>
 #include <typeinfo>
 #include <utility>
@@ -33,6 +46,17 @@
 #include <unordered_set>
 #include <vector>
 
+// POSIX headers for memory-mapped file access
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// x86 intrinsics for the optional AVX2 kernels
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
 #ifndef M_PI
   #define M_PI 3.141592653589793238462643383279
 #endif
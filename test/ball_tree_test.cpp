@@ -0,0 +1,57 @@
+#include "../src/core/tree/ball_tree.hpp"
+using namespace openml;
+
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+
+    MatType X, X_train, X_test;
+    ColVecType y;
+
+    data::loadtxt<MatType, ColVecType>("../dataset/iris.txt", X, y);
+
+    X_train = X.topRows(125);
+    X_test = X.bottomRows(25);
+
+    // same neighbors as the kd-tree for the euclidean metric
+    tree::BallTree<double> ball_tree(X_train);
+    tree::KDTree<double> kd_tree(X_train);
+    MatType distances1, distances2;
+    IdxMatType indices1, indices2;
+    std::tie(distances1, indices1) = ball_tree.query(X_test, 4);
+    std::tie(distances2, indices2) = kd_tree.query(X_test, 4);
+    std::cout << "distances1" << std::endl;
+    std::cout << distances1 << std::endl;
+    std::cout << "same as kd-tree: " << (indices1 == indices2) << std::endl;
+
+    for (std::string metric : {"cosine", "minkowski"}) {
+        tree::BallTree<double> metric_tree(X_train, 10, metric, 1, 3);
+        std::tie(distances1, indices1) = metric_tree.query(X_test.topRows(5), 3);
+        std::cout << metric << " distances" << std::endl;
+        std::cout << distances1 << std::endl;
+        std::cout << metric << " indices" << std::endl;
+        std::cout << indices1 << std::endl;
+    }
+
+    // haversine, (latitude, longitude) of cities in radians
+    MatType cities(4, 2);
+    cities << 48.8566, 2.3522,
+              51.5074, -0.1278,
+              40.7128, -74.0060,
+              35.6762, 139.6503;
+    cities *= M_PI / 180.0;
+    tree::BallTree<double> haversine_tree(cities, 1, "haversine");
+    std::tie(distances1, indices1) = haversine_tree.query(cities, 2);
+    std::cout << "haversine distances (km)" << std::endl;
+    std::cout << distances1 * 6371.0 << std::endl;
+
+    IdxVecType offsets, indices3;
+    ColVecType distances3;
+    std::tie(offsets, indices3, distances3) = ball_tree.query_radius(X_test, 0.5);
+    std::cout << "radius neighbors per query" << std::endl;
+    std::cout << (offsets.tail(25) - offsets.head(25)).transpose() << std::endl;
+    return 0;
+}
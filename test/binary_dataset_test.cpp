@@ -0,0 +1,52 @@
+#include "../src/methods/linear_model/linear_regression.hpp"
+using namespace openml;
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+
+    MatType X;
+    VecType y;
+
+    data::LoadStats stats;
+    stats = data::loadtxt<MatType, VecType>("../dataset/boston_house_price.txt", X, y);
+    std::cout << "loadtxt throughput = " << stats.throughput << " MB/s" << std::endl;
+
+    data::savebin<MatType, VecType>("../dataset/boston_house_price.bin", X, y);
+    data::BinaryDataset<double> dataset("../dataset/boston_house_price.bin", true);
+
+    std::cout << "rows = " << dataset.rows() << ", cols = " << dataset.cols() << std::endl;
+    std::cout << "max diff X = " << (dataset.X() - X).cwiseAbs().maxCoeff() << std::endl;
+    std::cout << "max diff y = " << (dataset.y() - y).cwiseAbs().maxCoeff() << std::endl;
+
+    linear_model::LinearRegression<double> lr;
+    lr.fit(dataset.X(), dataset.y());
+    VecType y_pred = lr.predict(dataset.X().topRows(5));
+    std::cout << y_pred << std::endl;
+
+    // a dataset can be moved into a container, the mapping is kept
+    std::vector<data::BinaryDataset<double>> datasets;
+    datasets.push_back(std::move(dataset));
+    std::cout << "max diff X after move = " 
+              << (datasets[0].X() - X).cwiseAbs().maxCoeff() << std::endl;
+
+    // a header whose sizes wrap around is rejected
+    {
+        std::fstream fs("../dataset/boston_house_price.bin", 
+            std::ios::binary | std::ios::in | std::ios::out);
+        std::uint64_t num_rows = std::uint64_t(1) << 61, num_cols = 1;
+        fs.seekp(offsetof(data::BinaryHeader, num_rows));
+        fs.write(reinterpret_cast<const char*>(&num_rows), sizeof(std::uint64_t));
+        fs.write(reinterpret_cast<const char*>(&num_cols), sizeof(std::uint64_t));
+    }
+    try {
+        data::BinaryDataset<double> corrupted("../dataset/boston_house_price.bin");
+        std::cout << "corrupted header rejected: 0" << std::endl;
+    }
+    catch (const std::runtime_error&) {
+        std::cout << "corrupted header rejected: 1" << std::endl;
+    }
+
+    std::remove("../dataset/boston_house_price.bin");
+    return 0;
+}
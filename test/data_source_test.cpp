@@ -0,0 +1,46 @@
+#include "../src/methods/linear_model/logistic_regression.hpp"
+using namespace openml;
+
+int main() {
+
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+
+    MatType X;
+    VecType y;
+    data::loadtxt<MatType, VecType>("../dataset/ionosphere.txt", X, y);
+
+    // read the text file by chunks of 4KB and shuffle within 64 samples
+    data::TextDataSource<double> text_source("../dataset/ionosphere.txt", 4096);
+    data::ShuffleDataSource<double> shuffle_source(text_source, 64);
+
+    linear_model::LogisticRegression<double> lr(
+        0.1, 0.0, 0.0001, 16, 2000, 5, "sgd", "None", true, false
+    );
+    lr.fit(shuffle_source);
+
+    VecType y_pred = lr.predict(X.topRows(10));
+    std::cout << "streaming y_pred" << std::endl;
+    std::cout << y_pred.transpose() << std::endl;
+
+    data::InMemoryDataSource<double> memory_source(X, y, true);
+    lr.fit(memory_source);
+    y_pred = lr.predict(X.topRows(10));
+    std::cout << "in-memory y_pred" << std::endl;
+    std::cout << y_pred.transpose() << std::endl;
+
+    // the last partial batch is dropped, as optimize(X, y) does
+    data::InMemoryDataSource<double> drop_source(X, y, true, "epoch", 64, 0, true);
+    MatType X_batch;
+    VecType y_batch;
+    std::size_t num_rows = 0, num_batches = 0;
+    drop_source.reset();
+    while (std::size_t n = drop_source.next_batch(X_batch, y_batch, 16)) {
+        num_rows += n;
+        ++num_batches;
+    }
+    std::cout << "drop_last: " << num_batches << " batches, " << num_rows 
+              << " of " << X.rows() << " samples" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "../src/core/tree/dynamic_kd_tree.hpp"
+using namespace openml;
+
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+
+    MatType X, X_train, X_test;
+    ColVecType y;
+
+    data::loadtxt<MatType, ColVecType>("../dataset/iris.txt", X, y);
+
+    X_train = X.topRows(125);
+    X_test = X.bottomRows(25);
+
+    // points inserted in small batches go through several levels
+    tree::DynamicKDTree<double> dynamic_tree(10, "euclidean", 16);
+    for (Eigen::Index i = 0; i < X_train.rows(); i += 25) {
+        dynamic_tree.insert(X_train.middleRows(i, 25));
+    }
+    MatType distances1, distances2;
+    IdxMatType indices1, indices2;
+    std::tie(distances1, indices1) = dynamic_tree.query(X_test, 4);
+    std::cout << "distances1" << std::endl;
+    std::cout << distances1 << std::endl;
+    std::cout << "indices1" << std::endl;
+    std::cout << indices1 << std::endl;
+
+    // remove the even points, the neighbors are those of a static tree
+    // built on the odd points
+    IdxVecType removed = IdxVecType::LinSpaced(63, 0, 124);
+    dynamic_tree.remove(removed);
+    std::tie(distances1, indices1) = dynamic_tree.query(X_test, 4);
+    IdxVecType odd = IdxVecType::LinSpaced(62, 1, 123);
+    tree::KDTree<double> kd_tree(X_train(odd, Eigen::all));
+    std::tie(distances2, indices2) = kd_tree.query(X_test, 4);
+    std::cout << "size " << dynamic_tree.size() << ", same as static tree: "
+              << (indices1 == odd(indices2.reshaped()).reshaped(25, 4)) << std::endl;
+
+    // compaction does not change the neighbors
+    dynamic_tree.compact(true);
+    MatType distances3;
+    IdxMatType indices3;
+    std::tie(distances3, indices3) = dynamic_tree.query(X_test, 4);
+    std::cout << "same after compaction: " << (indices3 == indices1) << std::endl;
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "../src/core/tree/hnsw.hpp"
+using namespace openml;
+
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using IdxVecType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, 1>;
+
+    MatType X, X_train, X_test;
+    ColVecType y;
+
+    data::loadtxt<MatType, ColVecType>("../dataset/iris.txt", X, y);
+
+    X_train = X.topRows(125);
+    X_test = X.bottomRows(25);
+
+    tree::HNSW<double> hnsw(16, 200, 50, "euclidean", 0);
+    hnsw.add(X_train);
+    MatType distances1, distances2;
+    IdxMatType indices1, indices2;
+    std::tie(distances1, indices1) = hnsw.query(X_test, 4);
+    std::cout << "distances1" << std::endl;
+    std::cout << distances1 << std::endl;
+
+    // recall@10 against the exact neighbors of the kd-tree
+    std::size_t k = 10;
+    random::Philox4x32 generator = random::make_generator(0);
+    MatType data = random::rand<MatType>(5000, 32, 0.0, 1.0, generator);
+    MatType queries = random::rand<MatType>(200, 32, 0.0, 1.0, generator);
+    tree::KDTree<double> kd_tree(data);
+    std::tie(distances2, indices2) = kd_tree.query(queries, k);
+
+    tree::HNSW<double> hnsw2(16, 200, 50, "euclidean", 0, 4);
+    hnsw2.add(data);
+    for (std::size_t ef : {10, 50, 200}) {
+        hnsw2.set_ef_search(ef);
+        std::tie(distances1, indices1) = hnsw2.query(queries, k);
+        std::size_t num_found = 0;
+        for (Eigen::Index i = 0; i < queries.rows(); ++i) {
+            for (std::size_t j = 0; j < k; ++j) {
+                num_found += (indices1.row(i).array() == indices2(i, j)).any();
+            }
+        }
+        std::cout << "ef_search = " << ef << ", recall@10 = "
+                  << static_cast<double>(num_found) / (queries.rows() * k) << std::endl;
+    }
+
+    // a loaded index gives the same neighbors
+    hnsw2.save("/tmp/hnsw_test.bin");
+    tree::HNSW<double> hnsw3;
+    hnsw3.load("/tmp/hnsw_test.bin");
+    hnsw3.set_ef_search(200);
+    MatType distances3;
+    IdxMatType indices3;
+    std::tie(distances3, indices3) = hnsw3.query(queries, k);
+    std::cout << "same after load: " << (indices3 == indices1) << std::endl;
+
+    // every point is returned when k is the size of the index
+    std::tie(distances1, indices1) = hnsw.query(X_test.topRows(1), X_train.rows());
+    std::sort(indices1.data(), indices1.data() + indices1.size());
+    std::cout << "all points returned: " 
+              << (indices1.row(0).transpose() == 
+                    IdxVecType::LinSpaced(X_train.rows(), 0, X_train.rows() - 1))
+              << std::endl;
+
+    // a truncated file is rejected before allocating
+    {
+        std::ifstream fin("/tmp/hnsw_test.bin", std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+        std::ofstream fout("/tmp/hnsw_truncated.bin", std::ios::binary | std::ios::trunc);
+        fout.write(content.data(), content.size() / 2);
+    }
+    try {
+        hnsw3.load("/tmp/hnsw_truncated.bin");
+        std::cout << "truncated file rejected: 0" << std::endl;
+    }
+    catch (const std::runtime_error& e) {
+        std::cout << "truncated file rejected: 1 (" << e.what() << ")" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "../src/methods/neighbors/ivf_pq.hpp"
+using namespace openml;
+
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+
+    MatType X, X_train, X_test;
+    ColVecType y;
+
+    data::loadtxt<MatType, ColVecType>("../dataset/iris.txt", X, y);
+
+    X_train = X.topRows(125);
+    X_test = X.bottomRows(25);
+
+    neighbors::IVFPQ<double> ivf_pq(4, 2, 2, 25, 0);
+    ivf_pq.fit(X_train);
+    MatType distances1, distances2;
+    IdxMatType indices1, indices2;
+    std::tie(distances1, indices1) = ivf_pq.query(X_test, 4);
+    std::cout << "distances1" << std::endl;
+    std::cout << distances1 << std::endl;
+
+    // recall@10 against the exact neighbors of the kd-tree,
+    // vectors of 32 features are stored in 8 or 16 bytes
+    std::size_t k = 10;
+    random::Philox4x32 generator = random::make_generator(0);
+    MatType centers = random::rand<MatType>(50, 32, 0.0, 1.0, generator);
+    MatType data = random::randn<MatType>(10000, 32, 0.0, 0.1, generator);
+    MatType queries = random::randn<MatType>(200, 32, 0.0, 0.1, generator);
+    for (Eigen::Index i = 0; i < data.rows(); ++i) {
+        data.row(i) += centers.row(i % 50);
+    }
+    for (Eigen::Index i = 0; i < queries.rows(); ++i) {
+        queries.row(i) += centers.row(i % 50);
+    }
+    tree::KDTree<double> kd_tree(data);
+    std::tie(distances2, indices2) = kd_tree.query(queries, k);
+
+    for (std::size_t m : {8, 16}) {
+        neighbors::IVFPQ<double> index(64, m, 1, 10, 0, 4);
+        index.fit(data);
+        for (std::size_t num_probes : {1, 4, 16}) {
+            index.set_num_probes(num_probes);
+            std::tie(distances1, indices1) = index.query(queries, k);
+            std::size_t num_found = 0;
+            for (Eigen::Index i = 0; i < queries.rows(); ++i) {
+                for (std::size_t j = 0; j < k; ++j) {
+                    num_found += (indices1.row(i).array() == indices2(i, j)).any();
+                }
+            }
+            std::cout << "code size = " << index.get_code_size()
+                      << ", num_probes = " << num_probes << ", recall@10 = "
+                      << static_cast<double>(num_found) / (queries.rows() * k) << std::endl;
+        }
+    }
+    return 0;
+}
@@ -27,5 +27,28 @@ int main() {
 
     knn.predict(X_test);
 
+    neighbors::KNearestNeighbors<double> knn_ball(
+        10, 4, "balltree", "euclidean"
+    );
+    knn_ball.fit(X_train, y_train);
+    y_pred = knn_ball.predict(X_test);
+    std::cout << "balltree y_pred" << std::endl;
+    std::cout << y_pred.transpose() << std::endl;
+
+    neighbors::KNearestNeighbors<double> knn_hnsw(
+        10, 4, "hnsw", "euclidean"
+    );
+    knn_hnsw.fit(X_train, y_train);
+    y_pred = knn_hnsw.predict(X_test);
+    std::cout << "hnsw y_pred" << std::endl;
+    std::cout << y_pred.transpose() << std::endl;
+
+    neighbors::KNearestNeighbors<double> knn_brute(
+        10, 4, "brute", "euclidean"
+    );
+    knn_brute.fit(X_train, y_train);
+    y_pred = knn_brute.predict(X_test);
+    std::cout << "brute y_pred" << std::endl;
+    std::cout << y_pred.transpose() << std::endl;
     
 }
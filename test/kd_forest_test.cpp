@@ -0,0 +1,65 @@
+#include "../src/core/tree/kd_forest.hpp"
+using namespace openml;
+
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using ColVecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+
+    MatType X, X_train, X_test;
+    ColVecType y;
+
+    data::loadtxt<MatType, ColVecType>("../dataset/iris.txt", X, y);
+
+    X_train = X.topRows(125);
+    X_test = X.bottomRows(25);
+
+    tree::KDForest<double> forest(X_train, 4, 10, "euclidean", 0);
+    MatType distances1, distances2;
+    IdxMatType indices1, indices2;
+    std::tie(distances1, indices1) = forest.query(X_test, 4, 32);
+    std::cout << "distances1" << std::endl;
+    std::cout << distances1 << std::endl;
+
+    // recall@10 against the exact neighbors of the kd-tree, points lie
+    // close to a 6 dimensional subspace of a 32 dimensional space
+    std::size_t k = 10;
+    random::Philox4x32 generator = random::make_generator(0);
+    MatType basis = random::randn<MatType>(6, 32, 0.0, 1.0, generator);
+    MatType data = random::rand<MatType>(20000, 6, 0.0, 1.0, generator) * basis + 
+        random::randn<MatType>(20000, 32, 0.0, 0.02, generator);
+    MatType queries = random::rand<MatType>(200, 6, 0.0, 1.0, generator) * basis + 
+        random::randn<MatType>(200, 32, 0.0, 0.02, generator);
+    tree::KDTree<double> kd_tree(data);
+    std::tie(distances2, indices2) = kd_tree.query(queries, k);
+
+    for (std::size_t num_trees : {1, 4}) {
+        tree::KDForest<double> forest2(data, num_trees, 10, "euclidean", 0);
+        for (std::size_t max_checks : {32, 128, 512}) {
+            std::tie(distances1, indices1) = forest2.query(queries, k, max_checks);
+            std::size_t num_found = 0;
+            for (Eigen::Index i = 0; i < queries.rows(); ++i) {
+                for (std::size_t j = 0; j < k; ++j) {
+                    num_found += (indices1.row(i).array() == indices2(i, j)).any();
+                }
+            }
+            std::cout << "num_trees = " << num_trees << ", max_checks = " << max_checks 
+                      << ", recall@10 = " << static_cast<double>(num_found) / (queries.rows() * k) 
+                      << std::endl;
+        }
+    }
+
+    // query latency with few checks, more threads must not be slower
+    MatType big_data = random::rand<MatType>(1000000, 4, 0.0, 1.0, generator);
+    MatType big_queries = random::rand<MatType>(4000, 4, 0.0, 1.0, generator);
+    for (int n_jobs : {1, 2, 4}) {
+        tree::KDForest<double> forest3(big_data, 4, 10, "euclidean", 0, n_jobs);
+        auto start = std::chrono::steady_clock::now();
+        std::tie(distances1, indices1) = forest3.query(big_queries, k, 32);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "n_jobs = " << n_jobs << ", max_checks = 32, query time = " 
+                  << elapsed.count() << "s" << std::endl;
+    }
+    return 0;
+}
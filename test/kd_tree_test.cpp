@@ -7,6 +7,7 @@ int main() {
     using RowVecType = Eigen::Matrix<double, 1, Eigen::Dynamic>;
     using ColVecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
     using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
 
     MatType X, X_train, X_test;
     ColVecType y;
@@ -25,12 +26,38 @@ int main() {
     std::cout << "indices1" << std::endl;
     std::cout << indices1 << std::endl;
 
-    // std::vector<std::pair<double, std::size_t>> knn;
-    std::vector<std::vector<std::pair<double, std::size_t>>> knn;
-    knn = kd_tree.query_radius(X_test, 0.5);
-    for (auto nn : knn) {
-        for (auto n : nn) {
-            std::cout << n.first << " " << n.second << " ";
+    // radius neighbors in CSR format, one range per query
+    IdxVecType offsets, indices2;
+    ColVecType distances2;
+    std::tie(offsets, indices2, distances2) = kd_tree.query_radius(X_test, 0.5);
+    for (Eigen::Index i = 0; i < X_test.rows(); ++i) {
+        for (Eigen::Index j = offsets(i); j < offsets(i + 1); ++j) {
+            std::cout << distances2(j) << " " << indices2(j) << " ";
+        }
+        std::cout << std::endl;
+    }
+
+    IdxVecType counts = kd_tree.query_radius_count(X_test, 0.5);
+    std::cout << "counts" << std::endl;
+    std::cout << counts.transpose() << std::endl;
+
+    // best-bin-first search, a budget of 20 checks against all the points
+    MatType distances3;
+    IdxMatType indices3;
+    std::tie(distances3, indices3) = kd_tree.query_approx(X_test, 4, 20);
+    std::cout << "approximate distances" << std::endl;
+    std::cout << distances3 << std::endl;
+    std::tie(distances3, indices3) = kd_tree.query_approx(X_test, 4, X_train.rows());
+    std::cout << "exact with a full budget: " << (distances3 == distances1) << std::endl;
+
+    // k nearest neighbors graph of the training points, self excluded
+    Eigen::SparseMatrix<double, Eigen::RowMajor> graph = kd_tree.kneighbors_graph(3);
+    Eigen::SparseMatrix<double, Eigen::RowMajor> mutual_graph = kd_tree.kneighbors_graph(3, true);
+    std::cout << "graph nonzeros " << graph.nonZeros() 
+              << " mutual nonzeros " << mutual_graph.nonZeros() << std::endl;
+    for (Eigen::Index i = 0; i < 5; ++i) {
+        for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(graph, i); it; ++it) {
+            std::cout << it.value() << " " << it.col() << " ";
         }
         std::cout << std::endl;
     }
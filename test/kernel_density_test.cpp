@@ -0,0 +1,46 @@
+#include "../src/methods/neighbors/kernel_density.hpp"
+using namespace openml;
+
+
+int main() {
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+
+    MatType X, X_train, X_test;
+    VecType y;
+
+    data::loadtxt<MatType, VecType>("../dataset/iris.txt", X, y);
+
+    X_train = X.topRows(125);
+    X_test = X.bottomRows(25);
+
+    for (std::string kernel : {"gaussian", "epanechnikov", "tophat"}) {
+        neighbors::KernelDensity<double> kde(0.5, kernel, "kdtree");
+        kde.fit(X_train);
+        VecType log_density1 = kde.score_samples(X_test);
+        std::cout << kernel << " log density" << std::endl;
+        std::cout << log_density1.transpose() << std::endl;
+
+        neighbors::KernelDensity<double> kde2(0.5, kernel, "balltree");
+        kde2.fit(X_train);
+        VecType log_density2 = kde2.score_samples(X_test);
+        std::cout << "max difference of the density with balltree: " 
+                  << (log_density2.array().exp() - log_density1.array().exp()).abs().maxCoeff() 
+                  << std::endl;
+    }
+
+    // the approximate density is within rtol of the exact one
+    random::Philox4x32 generator = random::make_generator(0);
+    MatType data = random::randn<MatType>(20000, 3, 0.0, 1.0, generator);
+    MatType samples = data.topRows(200);
+    neighbors::KernelDensity<double> kde3(0.2, "gaussian", "kdtree");
+    neighbors::KernelDensity<double> kde4(0.2, "gaussian", "kdtree", 0.0, 1e-3);
+    kde3.fit(data);
+    kde4.fit(data);
+    VecType log_density3 = kde3.score_samples(samples);
+    VecType log_density4 = kde4.score_samples(samples);
+    std::cout << "max relative error with rtol = 1e-3: " 
+              << ((log_density4 - log_density3).array().exp() - 1.0).abs().maxCoeff() << std::endl;
+    std::cout << "score: " << kde4.score(samples) << std::endl;
+    return 0;
+}
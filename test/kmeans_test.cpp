@@ -20,6 +20,31 @@ int main() {
     std::cout << "y_pred" << std::endl;
     std::cout << y_pred << std::endl;
 
+    // accelerated algorithms give the same clustering as lloyd
+    for (std::string algorithm : {"lloyd", "elkan", "hamerly", "filtering"}) {
+        cluster::KMeans<double> kmeans_bounds("kmeans++", 1, 3, 300, 1e-4, 0, 1, algorithm);
+        kmeans_bounds.fit(X);
+        VecType y_pred_bounds = kmeans_bounds.predict(X);
+        std::cout << algorithm << " y_pred" << std::endl;
+        std::cout << y_pred_bounds.transpose() << std::endl;
+    }
+
+    // scalable kmeans|| initialization
+    cluster::KMeans<double> kmeans_parallel_init("kmeans||", 1, 3, 300, 1e-4, 0);
+    kmeans_parallel_init.fit(X);
+    std::cout << "kmeans|| y_pred" << std::endl;
+    std::cout << kmeans_parallel_init.predict(X).transpose() << std::endl;
+    std::cout << "kmeans|| inertia = " << kmeans_parallel_init.get_inertia() << std::endl;
+
+    // restarts are executed concurrently, the best run does not depend on n_jobs
+    for (int n_jobs : {1, 4}) {
+        cluster::KMeans<double> kmeans_restarts("kmeans++", 10, 3, 300, 1e-4, 0, n_jobs);
+        kmeans_restarts.fit(X);
+        std::cout << "n_jobs = " << n_jobs 
+                  << ", inertia = " << kmeans_restarts.get_inertia() 
+                  << ", n_iter = " << kmeans_restarts.get_num_iters() << std::endl;
+    }
+
 
     return 0;
 }
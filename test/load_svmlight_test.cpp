@@ -0,0 +1,28 @@
+#include "../src/core/data/load.hpp"
+using namespace openml;
+
+int main() {
+    using SpMatType = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, 1>;
+
+    SpMatType X;
+    VecType y;
+    IdxVecType qid;
+
+    data::LoadStats stats;
+    stats = data::load_svmlight<SpMatType, VecType, IdxVecType>(
+        "../dataset/svmlight.txt", X, y, &qid
+    );
+
+    std::cout << "num_samples = " << stats.num_rows 
+              << ", num_features = " << stats.num_cols 
+              << ", nnz = " << X.nonZeros() << std::endl;
+    std::cout << "X" << std::endl;
+    std::cout << X << std::endl;
+    std::cout << "y" << std::endl;
+    std::cout << y.transpose() << std::endl;
+    std::cout << "qid" << std::endl;
+    std::cout << qid.transpose() << std::endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include "../src/methods/cluster/mini_batch_kmeans.hpp"
+using namespace openml;
+
+int main() {
+
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+
+    MatType X;
+    VecType y;
+
+    data::loadtxt<MatType, VecType>("../dataset/iris.txt", X, y);
+
+    // fit on the whole matrix, batches are sampled at each epoch
+    cluster::MiniBatchKMeans<double> mbkmeans("kmeans++", 3, 32, 100, 0.0, 10, 0.01, 0);
+    mbkmeans.fit(X);
+    VecType y_pred = mbkmeans.predict(X);
+    std::cout << "y_pred" << std::endl;
+    std::cout << y_pred.transpose() << std::endl;
+    std::cout << "centroids" << std::endl;
+    std::cout << mbkmeans.get_centroids() << std::endl;
+
+    // streaming fit on a data source
+    data::InMemoryDataSource<double> source(X, y, true, "epoch", 64, 0);
+    cluster::MiniBatchKMeans<double> mbkmeans_source("kmeans++", 3, 32, 100, 0.0, 10, 0.01, 0);
+    mbkmeans_source.fit(source);
+    std::cout << "data source y_pred" << std::endl;
+    std::cout << mbkmeans_source.predict(X).transpose() << std::endl;
+
+    // incremental updates, one batch at a time
+    cluster::MiniBatchKMeans<double> mbkmeans_partial("kmeans++", 3, 32, 1, 0.0, 10, 0.01, 0);
+    MatType shuffled_X;
+    random::shuffle_data(X, shuffled_X, 1, 0);
+    for (std::size_t epoch = 0; epoch < 10; ++epoch) {
+        for (std::size_t i = 0; i < static_cast<std::size_t>(X.rows()); i += 30) {
+            std::size_t num_rows = std::min<std::size_t>(30, X.rows() - i);
+            mbkmeans_partial.partial_fit(shuffled_X.middleRows(i, num_rows));
+        }
+    }
+    std::cout << "partial_fit y_pred" << std::endl;
+    std::cout << mbkmeans_partial.predict(X).transpose() << std::endl;
+    std::cout << "counts" << std::endl;
+    std::cout << mbkmeans_partial.get_counts().transpose() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "../src/core.hpp"
+using namespace openml;
+
+int main() {
+
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+
+    MatType X;
+    VecType y;
+    data::loadtxt<MatType, VecType>("../dataset/iris.txt", X, y);
+    MatType Y = X.topRows(10);
+
+    for (std::string metric : {"euclidean", "sqeuclidean", "manhattan", "cosine"}) {
+        MatType distances = metric::pairwise_distances<MatType>(X, Y, metric, 4);
+
+        // compare with distances computed pair by pair
+        double max_error = 0.0;
+        for (Eigen::Index i = 0; i < X.rows(); ++i) {
+            for (Eigen::Index j = 0; j < Y.rows(); ++j) {
+                double dist;
+                if (metric == "euclidean") {
+                    dist = (X.row(i) - Y.row(j)).norm();
+                }
+                else if (metric == "sqeuclidean") {
+                    dist = (X.row(i) - Y.row(j)).squaredNorm();
+                }
+                else if (metric == "manhattan") {
+                    dist = (X.row(i) - Y.row(j)).cwiseAbs().sum();
+                }
+                else {
+                    dist = 1.0 - X.row(i).dot(Y.row(j)) / (X.row(i).norm() * Y.row(j).norm());
+                }
+                max_error = std::max(max_error, std::abs(dist - distances(i, j)));
+            }
+        }
+        std::cout << metric << " max error: " << max_error << std::endl;
+    }
+
+    // closest centers and k nearest neighbors without the full distance matrix
+    IdxVecType argmin;
+    VecType min_dist;
+    std::tie(argmin, min_dist) = metric::pairwise_distances_argmin_min<MatType, VecType, IdxVecType>(
+        X.bottomRows(5), Y, "euclidean", 4
+    );
+    std::cout << "argmin: " << argmin.transpose() << std::endl;
+    std::cout << "min_dist: " << min_dist.transpose() << std::endl;
+
+    MatType knn_dist;
+    IdxMatType knn_indices;
+    std::tie(knn_dist, knn_indices) = metric::pairwise_distances_topk<MatType, IdxMatType, VecType>(
+        X.topRows(3), X, 4, "euclidean", 4
+    );
+    std::cout << "knn_indices" << std::endl << knn_indices << std::endl;
+    std::cout << "knn_dist" << std::endl << knn_dist << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "../src/core.hpp"
+using namespace openml;
+
+int main() {
+
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using VecType = Eigen::Matrix<double, Eigen::Dynamic, 1>;
+    using IdxMatType = Eigen::Matrix<Eigen::Index, Eigen::Dynamic, Eigen::Dynamic>;
+
+    // parallel loop with uneven cost per index
+    std::size_t num_items = 10000;
+    std::vector<double> values(num_items, 0.0);
+    parallel::parallel_for(0, num_items, 8, 4, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            double sum = 0.0;
+            for (std::size_t j = 0; j < i % 1000; ++j) {
+                sum += std::sqrt(static_cast<double>(j));
+            }
+            values[i] = sum;
+        }
+    });
+
+    // the reduction does not depend on the number of threads
+    auto partial_sum = [&](std::size_t first, std::size_t last) {
+        double sum = 0.0;
+        for (std::size_t i = first; i < last; ++i) {
+            sum += values[i];
+        }
+        return sum;
+    };
+    auto add = [](double a, double b) { return a + b; };
+    double sum1 = parallel::parallel_reduce(0, num_items, 100, 1, 0.0, partial_sum, add);
+    double sum4 = parallel::parallel_reduce(0, num_items, 100, 4, 0.0, partial_sum, add);
+    std::cout << "sum: " << sum1 << ", same result: " << (sum1 == sum4) << std::endl;
+
+    // nested loops share the pool without deadlock
+    std::atomic<std::size_t> count{0};
+    parallel::parallel_for(0, 64, 1, 4, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            parallel::parallel_for(0, 100, 10, 4, [&](std::size_t a, std::size_t b) {
+                count += b - a;
+            });
+        }
+    });
+    std::cout << "nested count: " << count.load() << std::endl;
+
+    // a waiting thread blocks instead of spinning once nothing is left to 
+    // steal, the process uses little cpu time while the tasks sleep
+    std::clock_t cpu_start = std::clock();
+    parallel::parallel_for(0, 2, 1, 4, [&](std::size_t first, std::size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(first == 0 ? 10 : 200));
+    });
+    double cpu_time = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    std::cout << "cpu time while waiting: " << cpu_time << "s" << std::endl;
+
+    // exceptions are propagated to the caller
+    try {
+        parallel::parallel_for(0, 1000, 10, 4, [&](std::size_t first, std::size_t last) {
+            if (first <= 500 && 500 < last) {
+                throw std::runtime_error("error at index 500");
+            }
+        });
+    }
+    catch (const std::exception& e) {
+        std::cout << "caught: " << e.what() << std::endl;
+    }
+
+    // KD-tree queries with several threads
+    MatType X;
+    VecType y;
+    data::loadtxt<MatType, VecType>("../dataset/iris.txt", X, y);
+    tree::KDTree<double> tree1(X, 10, "euclidean", 1);
+    tree::KDTree<double> tree4(X, 10, "euclidean", 4);
+    MatType distances1, distances4;
+    IdxMatType indices1, indices4;
+    std::tie(distances1, indices1) = tree1.query(X, 5);
+    std::tie(distances4, indices4) = tree4.query(X, 5);
+    std::cout << "same neighbors: " << (indices1 == indices4 && distances1 == distances4) << std::endl;
+
+    return 0;
+}
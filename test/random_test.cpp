@@ -0,0 +1,42 @@
+#include "../src/core.hpp"
+using namespace openml;
+
+int main() {
+
+    using MatType = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic>;
+    using IdxVecType = Eigen::Vector<Eigen::Index, Eigen::Dynamic>;
+
+    // known answer of Philox4x32-10 for a zero key and counter
+    random::Philox4x32::BlockType block = random::Philox4x32::generate(0, 0, 0);
+    std::cout << std::hex << block[0] << " " << block[1] << " " 
+              << block[2] << " " << block[3] << std::dec << std::endl;
+
+    // same seed gives same matrices, whatever the number of threads
+    random::Philox4x32 generator1(42), generator2(42);
+    MatType X1 = random::randn<MatType>(1000, 200, 0.0, 1.0, generator1, 1);
+    MatType X2 = random::randn<MatType>(1000, 200, 0.0, 1.0, generator2, 4);
+    std::cout << "same values: " << (X1 == X2) << std::endl;
+    std::cout << "mean: " << X1.mean() << ", var: " 
+              << (X1.array() - X1.mean()).square().mean() << std::endl;
+
+    // the global seed makes calls without generator reproducible
+    random::seed(2023);
+    MatType U1 = random::rand<MatType>(3, 3);
+    IdxVecType p1 = random::permutation<IdxVecType>(10);
+    random::seed(2023);
+    MatType U2 = random::rand<MatType>(3, 3);
+    IdxVecType p2 = random::permutation<IdxVecType>(10);
+    std::cout << U1 << std::endl;
+    std::cout << "permutation: " << p1.transpose() << std::endl;
+    std::cout << "reproducible: " << (U1 == U2 && p1 == p2) << std::endl;
+
+    // independent substreams for threads
+    random::Philox4x32 stream0 = generator1.substream(0);
+    random::Philox4x32 stream1 = generator1.substream(1);
+    std::cout << "substreams: " << stream0() << " " << stream1() << std::endl;
+
+    auto ints = random::randint<int>(2, 8, 0, 9);
+    std::cout << ints << std::endl;
+
+    return 0;
+}